@@ -0,0 +1,91 @@
+#ifndef BENCH_COMMON_H
+#define BENCH_COMMON_H
+
+#include "instant-font.h"
+
+//
+// Shared setup for benchmarks: headless SDL (dummy video driver)
+// with software renderer drawing into an offscreen surface.
+//
+
+const int kTargetWidth  = 1920;
+const int kTargetHeight = 1080;
+
+// =============================================================================
+
+struct Headless
+{
+  SDL_Surface*  Target   = nullptr;
+  SDL_Renderer* Renderer = nullptr;
+};
+
+// =============================================================================
+
+bool InitHeadless(Headless& headless)
+{
+  SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
+
+  if (SDL_Init(SDL_INIT_VIDEO) != 0)
+  {
+    printf("SDL_Init Error: %s\n", SDL_GetError());
+    return false;
+  }
+
+  headless.Target = SDL_CreateRGBSurfaceWithFormat(0,
+                                                   kTargetWidth,
+                                                   kTargetHeight,
+                                                   32,
+                                                   SDL_PIXELFORMAT_RGBA32);
+  if (headless.Target == nullptr)
+  {
+    printf("%s\n", SDL_GetError());
+    return false;
+  }
+
+  headless.Renderer = SDL_CreateSoftwareRenderer(headless.Target);
+  if (headless.Renderer == nullptr)
+  {
+    printf("%s\n", SDL_GetError());
+    return false;
+  }
+
+  return true;
+}
+
+// =============================================================================
+
+void ShutdownHeadless(Headless& headless)
+{
+  SDL_DestroyRenderer(headless.Renderer);
+  SDL_FreeSurface(headless.Target);
+
+  SDL_Quit();
+}
+
+// =============================================================================
+
+double ToSeconds(uint64_t ticks)
+{
+  return (double)ticks / (double)SDL_GetPerformanceFrequency();
+}
+
+// =============================================================================
+
+std::string MakeLine(size_t length)
+{
+  const char* sample = "The quick brown fox jumps over the lazy dog 0123 ";
+
+  size_t sampleLength = strlen(sample);
+
+  std::string line;
+  line.reserve(length);
+
+  for (size_t i = 0; i < length; i++)
+  {
+    line += sample[i % sampleLength];
+  }
+
+  return line;
+}
+
+#endif
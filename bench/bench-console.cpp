@@ -0,0 +1,99 @@
+#include "bench-common.h"
+
+#include "instant-font-console.h"
+
+//
+// Throughput of IFConsole on synthetic compiler-like output with SGR
+// colors, fed in pipe-sized chunks, and cost of drawing a full panel.
+//
+
+const size_t kOutputSize = 64 * 1024 * 1024;
+const size_t kChunkSize  = 4096;
+const size_t kPanelRows  = 100;
+const int    kDrawFrames = 50;
+
+// =============================================================================
+
+std::string MakeToolOutput(size_t size)
+{
+  const char* lines[] =
+  {
+    "\x1b[1msrc/render.cpp:120:7: \x1b[1;31merror: \x1b[0m"
+    "use of undeclared identifier 'glyph'\n",
+    "\x1b[1msrc/render.cpp:98:12: \x1b[1;35mwarning: \x1b[0m"
+    "unused variable 'scale' [-Wunused-variable]\n",
+    "[ 42%] \x1b[32mBuilding CXX object CMakeFiles/app.dir/main.cpp.o\x1b[0m\n",
+    "\x1b[38;5;208m[  RUN   ]\x1b[0m FontTest.Layout\n",
+    "\x1b[38;2;0;200;80m[  PASS  ]\x1b[0m FontTest.Layout (3 ms)\n",
+    "plain line of output without any escape sequences at all\n",
+  };
+
+  std::string output;
+  output.reserve(size);
+
+  size_t i = 0;
+
+  while (output.length() < size)
+  {
+    output += lines[i % SDL_arraysize(lines)];
+    i++;
+  }
+
+  return output;
+}
+
+// =============================================================================
+
+int main(int argc, char* argv[])
+{
+  Headless headless;
+  if (not InitHeadless(headless))
+  {
+    return 1;
+  }
+
+  if (not IF::Instance().Init(headless.Renderer))
+  {
+    return 1;
+  }
+
+  std::string output = MakeToolOutput(kOutputSize);
+
+  IFConsole console(10000, 200);
+
+  uint64_t before = SDL_GetPerformanceCounter();
+
+  for (size_t offset = 0; offset < output.length(); offset += kChunkSize)
+  {
+    size_t size = std::min(kChunkSize, output.length() - offset);
+    console.Write(output.data() + offset, size);
+  }
+
+  double seconds = ToSeconds(SDL_GetPerformanceCounter() - before);
+
+  printf("Write: %.1f MB/s (%zu MB in %zu byte chunks)\n",
+         (double)output.length() / seconds / (1024.0 * 1024.0),
+         output.length() / (1024 * 1024),
+         kChunkSize);
+
+  uint64_t total = 0;
+
+  for (int frame = 0; frame < kDrawFrames; frame++)
+  {
+    SDL_RenderClear(headless.Renderer);
+
+    uint64_t drawStart = SDL_GetPerformanceCounter();
+
+    console.Draw(0, 0, kPanelRows);
+
+    total += SDL_GetPerformanceCounter() - drawStart;
+  }
+
+  printf("Draw:  %.1f us per %zu rows (including rasterization)\n",
+         ToSeconds(total) * 1e6 / kDrawFrames,
+         kPanelRows);
+
+  ShutdownHeadless(headless);
+
+  return 0;
+}
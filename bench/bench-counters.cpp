@@ -0,0 +1,94 @@
+#include "bench-common.h"
+
+#include "instant-font-counter.h"
+
+//
+// Cost of a screen of changing numeric readouts: Printf of every line
+// against IFCounter, which only retextures digits that changed.
+// Time is measured up to submission, so rasterization isn't included.
+//
+
+const size_t kCounters = 48;
+const int    kFrames   = 2000;
+
+// =============================================================================
+
+int main(int argc, char* argv[])
+{
+  Headless headless;
+  if (not InitHeadless(headless))
+  {
+    return 1;
+  }
+
+  if (not IF::Instance().Init(headless.Renderer))
+  {
+    return 1;
+  }
+
+  //
+  // Layout itself is measured, not replay of cached layouts.
+  //
+  IF::Instance().SetLayoutCache(0);
+
+  IF& font = IF::Instance();
+
+  int lineHeight = font.GlyphHeight() + 1;
+
+  uint64_t printfTicks = 0;
+
+  for (int frame = 0; frame < kFrames; frame++)
+  {
+    uint64_t before = SDL_GetPerformanceCounter();
+
+    font.BeginBatch();
+
+    for (size_t i = 0; i < kCounters; i++)
+    {
+      font.Printf(0, i * lineHeight,
+                  IF::TextParams::Set(0xFFFFFF),
+                  "Ticks %8llu",
+                  (unsigned long long)(frame * (i + 1)));
+    }
+
+    printfTicks += SDL_GetPerformanceCounter() - before;
+
+    font.Flush();
+  }
+
+  std::vector<IFCounter> counters(kCounters, IFCounter("Ticks ", 8));
+
+  for (size_t i = 0; i < kCounters; i++)
+  {
+    counters[i].SetPosition(0, i * lineHeight);
+  }
+
+  uint64_t counterTicks = 0;
+
+  for (int frame = 0; frame < kFrames; frame++)
+  {
+    uint64_t before = SDL_GetPerformanceCounter();
+
+    font.BeginBatch();
+
+    for (size_t i = 0; i < kCounters; i++)
+    {
+      counters[i].Set((uint64_t)(frame * (i + 1)));
+      counters[i].Draw();
+    }
+
+    counterTicks += SDL_GetPerformanceCounter() - before;
+
+    font.Flush();
+  }
+
+  printf("%zu readouts per frame, time up to submission:\n", kCounters);
+  printf("  Printf:    %.2f us per frame\n",
+         ToSeconds(printfTicks) * 1e6 / kFrames);
+  printf("  IFCounter: %.2f us per frame\n",
+         ToSeconds(counterTicks) * 1e6 / kFrames);
+
+  ShutdownHeadless(headless);
+
+  return 0;
+}
@@ -0,0 +1,108 @@
+#include "bench-common.h"
+
+//
+// Compares scalar and vectorized (AVX2) quad generation in Print.
+// Runs headless on the software renderer. Only building of the batch
+// is timed, rasterization in Flush() is not.
+//
+
+const int kRepeats       = 50;
+const int kLinesPerBatch = 64;
+
+const std::vector<size_t> LineLengths = { 16, 64, 256, 1024 };
+
+// =============================================================================
+
+std::string MakeHexLine(size_t length)
+{
+  const char* hex = "0123456789ABCDEF";
+
+  std::string line;
+  line.reserve(length);
+
+  for (size_t i = 0; i < length; i++)
+  {
+    line += ((i % 3) == 2) ? ' ' : hex[(i * 7) % 16];
+  }
+
+  return line;
+}
+
+// =============================================================================
+
+double Measure(const std::string& line, bool vectorized)
+{
+  IF::Instance().SetVectorized(vectorized);
+
+  uint64_t total = 0;
+
+  for (int rep = 0; rep < kRepeats; rep++)
+  {
+    IF::Instance().BeginBatch();
+
+    uint64_t before = SDL_GetPerformanceCounter();
+
+    for (int i = 0; i < kLinesPerBatch; i++)
+    {
+      IF::Instance().Print(0, i * 10, line);
+    }
+
+    total += SDL_GetPerformanceCounter() - before;
+
+    IF::Instance().Flush();
+  }
+
+  double glyphs = (double)line.length() * kLinesPerBatch * kRepeats;
+
+  return ToSeconds(total) * 1e9 / glyphs;
+}
+
+// =============================================================================
+
+int main(int argc, char* argv[])
+{
+  Headless headless;
+  if (not InitHeadless(headless))
+  {
+    return 1;
+  }
+
+  if (not IF::Instance().Init(headless.Renderer))
+  {
+    return 1;
+  }
+
+  //
+  // Layout itself is measured, not replay of cached layouts.
+  //
+  IF::Instance().SetLayoutCache(0);
+
+#if defined(__AVX2__)
+  printf("Vector path: AVX2\n\n");
+#else
+  printf("Vector path: none (build with -march=native to enable)\n\n");
+#endif
+
+  //
+  // Warm up caches and let vertex buffer grow to its final size.
+  //
+  Measure(MakeHexLine(LineLengths.back()), false);
+
+  printf("%8s %14s %14s %8s\n",
+         "length", "scalar ns/gl", "vector ns/gl", "speedup");
+
+  for (size_t length : LineLengths)
+  {
+    std::string line = MakeHexLine(length);
+
+    double scalar = Measure(line, false);
+    double vector = Measure(line, true);
+
+    printf("%8zu %14.2f %14.2f %7.2fx\n",
+           length, scalar, vector, scalar / vector);
+  }
+
+  ShutdownHeadless(headless);
+
+  return 0;
+}
@@ -0,0 +1,271 @@
+#include "bench-common.h"
+
+#include <SDL2/SDL_test_font.h>
+
+//
+// Microbenchmarks of the text pipeline, run headless on the software
+// renderer:
+//
+//   - Init time
+//   - Print throughput across string lengths and scales
+//   - Printf formatting overhead compared to Print of the same string
+//   - immediate vs batched frame (draw calls per frame)
+//   - SDLTest_DrawString from SDL_test as a baseline
+//
+
+const int kFrames        = 20;
+const int kLinesPerFrame = 64;
+
+const std::vector<size_t> LineLengths  = { 8, 32, 128, 512 };
+const std::vector<double> ScaleFactors = { 1.0, 1.5, 2.0 };
+
+// =============================================================================
+
+void BenchInit(SDL_Renderer* r)
+{
+  uint64_t before = SDL_GetPerformanceCounter();
+
+  bool ok = IF::Instance().Init(r);
+
+  uint64_t after = SDL_GetPerformanceCounter();
+
+  printf("Init: %.1f us%s\n\n",
+         ToSeconds(after - before) * 1e6,
+         ok ? "" : " (FAILED)");
+
+  //
+  // Layout itself is measured, not replay of cached layouts.
+  //
+  IF::Instance().SetLayoutCache(0);
+}
+
+// =============================================================================
+
+//
+// Returns millions of glyphs per second.
+//
+double MeasurePrint(SDL_Renderer* r, const std::string& line, double scale)
+{
+  int lineHeight = (int)(IF::Instance().GlyphHeight() * scale);
+
+  uint64_t total = 0;
+
+  for (int frame = 0; frame < kFrames; frame++)
+  {
+    SDL_RenderClear(r);
+
+    uint64_t before = SDL_GetPerformanceCounter();
+
+    for (int i = 0; i < kLinesPerFrame; i++)
+    {
+      IF::Instance().Print(0,
+                           (i * lineHeight) % kTargetHeight,
+                           line,
+                           0xFFFFFF,
+                           IF::TextAlignment::LEFT,
+                           scale);
+    }
+
+    total += SDL_GetPerformanceCounter() - before;
+  }
+
+  double glyphs = (double)line.length() * kLinesPerFrame * kFrames;
+
+  return glyphs / ToSeconds(total) / 1e6;
+}
+
+// =============================================================================
+
+//
+// Same as above, but with SDLTest_DrawString (8x8 font, no scaling).
+//
+double MeasureSDLTest(SDL_Renderer* r, const std::string& line)
+{
+  uint64_t total = 0;
+
+  for (int frame = 0; frame < kFrames; frame++)
+  {
+    SDL_RenderClear(r);
+
+    uint64_t before = SDL_GetPerformanceCounter();
+
+    for (int i = 0; i < kLinesPerFrame; i++)
+    {
+      SDLTest_DrawString(r, 0, (i * 8) % kTargetHeight, line.data());
+    }
+
+    total += SDL_GetPerformanceCounter() - before;
+  }
+
+  double glyphs = (double)line.length() * kLinesPerFrame * kFrames;
+
+  return glyphs / ToSeconds(total) / 1e6;
+}
+
+// =============================================================================
+
+void BenchPrint(SDL_Renderer* r)
+{
+  printf("Print throughput, Mglyphs/s\n\n");
+
+  printf("%8s", "length");
+  for (double scale : ScaleFactors)
+  {
+    printf("   scale %.1f", scale);
+  }
+  printf("   SDLTest\n");
+
+  for (size_t length : LineLengths)
+  {
+    std::string line = MakeLine(length);
+
+    printf("%8zu", length);
+
+    for (double scale : ScaleFactors)
+    {
+      printf(" %11.2f", MeasurePrint(r, line, scale));
+    }
+
+    printf(" %9.2f\n", MeasureSDLTest(r, line));
+  }
+
+  printf("\n");
+}
+
+// =============================================================================
+
+void BenchPrintf(SDL_Renderer* r)
+{
+  const int kCalls = 20000;
+
+  IF::TextParams params;
+
+  uint64_t printfTicks = 0;
+  uint64_t printTicks  = 0;
+
+  std::string preformatted = "Delta time = 1234567";
+
+  for (int pass = 0; pass < 2; pass++)
+  {
+    SDL_RenderClear(r);
+
+    uint64_t before = SDL_GetPerformanceCounter();
+
+    for (int i = 0; i < kCalls; i++)
+    {
+      if (pass == 0)
+      {
+        IF::Instance().Printf(0, 0, params, "Delta time = %llu", 1234567ULL);
+      }
+      else
+      {
+        IF::Instance().Print(0, 0, preformatted);
+      }
+    }
+
+    uint64_t ticks = SDL_GetPerformanceCounter() - before;
+
+    if (pass == 0)
+    {
+      printfTicks = ticks;
+    }
+    else
+    {
+      printTicks = ticks;
+    }
+  }
+
+  double printfNs = ToSeconds(printfTicks) * 1e9 / kCalls;
+  double printNs  = ToSeconds(printTicks)  * 1e9 / kCalls;
+
+  printf("Printf: %.1f ns/call, Print of same string: %.1f ns/call,"
+         " formatting overhead: %.1f ns/call\n\n",
+         printfNs, printNs, printfNs - printNs);
+}
+
+// =============================================================================
+
+void BenchFrame(SDL_Renderer* r)
+{
+  const int kStrings = 200;
+
+  std::string line = MakeLine(40);
+
+  printf("Frame of %d strings, %zu chars each\n\n", kStrings, line.length());
+  //
+  // Draw calls are only known from INSTANT_FONT_STATS counters,
+  // without them the column is left out.
+  //
+#ifdef INSTANT_FONT_STATS
+  printf("%10s %10s %12s\n", "mode", "draws", "ms/frame");
+#else
+  printf("%10s %12s\n", "mode", "ms/frame");
+#endif
+
+  for (int batched = 0; batched < 2; batched++)
+  {
+    uint64_t total = 0;
+
+    for (int frame = 0; frame < kFrames; frame++)
+    {
+      SDL_RenderClear(r);
+
+      IF::Instance().ResetFrameStats();
+
+      uint64_t before = SDL_GetPerformanceCounter();
+
+      if (batched)
+      {
+        IF::Instance().BeginBatch();
+      }
+
+      for (int i = 0; i < kStrings; i++)
+      {
+        IF::Instance().Print((i % 4) * 400, (i / 4) * 10, line);
+      }
+
+      if (batched)
+      {
+        IF::Instance().Flush();
+      }
+
+      total += SDL_GetPerformanceCounter() - before;
+    }
+
+#ifdef INSTANT_FONT_STATS
+    printf("%10s %10llu %12.3f\n",
+           batched ? "batched" : "immediate",
+           (unsigned long long)IF::Instance().GetFrameStats().DrawCalls,
+           ToSeconds(total) * 1e3 / kFrames);
+#else
+    printf("%10s %12.3f\n",
+           batched ? "batched" : "immediate",
+           ToSeconds(total) * 1e3 / kFrames);
+#endif
+  }
+
+  printf("\n");
+}
+
+// =============================================================================
+
+int main(int argc, char* argv[])
+{
+  Headless headless;
+  if (not InitHeadless(headless))
+  {
+    return 1;
+  }
+
+  BenchInit(headless.Renderer);
+
+  BenchPrint(headless.Renderer);
+  BenchPrintf(headless.Renderer);
+  BenchFrame(headless.Renderer);
+
+  SDLTest_CleanupTextDrawing();
+
+  ShutdownHeadless(headless);
+
+  return 0;
+}
@@ -0,0 +1,274 @@
+#include "bench-common.h"
+
+#include <algorithm>
+
+//
+// End-to-end stress scene. Same kind of content as example.cpp, but with
+// configurable workload, running for a fixed number of frames headless
+// and reporting frame time percentiles.
+//
+// Usage: stress [--frames N] [--strings N] [--length N] [--colors N]
+//               [--scales 1,1.5,2] [--static F] [--mode immediate|batched]
+//
+
+const std::vector<std::string> LoremIpsum =
+{
+  "One, two, three, four.",
+  "ax += 5, by = 6%, dx/dy = 33$, i++, j--",
+  "db qp ad ab ,.- dx dz dy",
+  "#!/bin/bash",
+  "A quick brown fox jumps over a lazy dog.",
+  "ls -la ; echo \"test \\n\" && rm -rf /",
+  "SELECT * FROM table WHERE `id` >= 42 AND `rating` = '30%'",
+  R"({ "root" : { "key1" : "value" }, { "key2" : 33 } })",
+};
+
+const std::vector<uint32_t> Palette =
+{
+  0xFFFFFF, 0xFF0000, 0x00FF00, 0x0088FF,
+  0xFFFF00, 0xFF00FF, 0x00FFFF, 0x888888
+};
+
+// =============================================================================
+
+struct Config
+{
+  int    Frames   = 500;
+  int    Strings  = 200;
+  size_t Length   = 40;
+  int    Colors   = 4;
+  double Static   = 0.8;
+  bool   Batched  = false;
+
+  std::vector<double> Scales = { 1.0 };
+};
+
+// =============================================================================
+
+bool ParseArgs(int argc, char* argv[], Config& config)
+{
+  for (int i = 1; i < argc; i++)
+  {
+    std::string arg = argv[i];
+
+    if (i + 1 >= argc)
+    {
+      printf("Missing value for %s\n", arg.data());
+      return false;
+    }
+
+    const char* value = argv[++i];
+
+    if (arg == "--frames")
+    {
+      config.Frames = std::max(1, std::atoi(value));
+    }
+    else if (arg == "--strings")
+    {
+      config.Strings = std::max(0, std::atoi(value));
+    }
+    else if (arg == "--length")
+    {
+      config.Length = std::max(1, std::atoi(value));
+    }
+    else if (arg == "--colors")
+    {
+      config.Colors = std::max(1, std::atoi(value));
+    }
+    else if (arg == "--static")
+    {
+      config.Static = std::min(1.0, std::max(0.0, std::atof(value)));
+    }
+    else if (arg == "--mode")
+    {
+      config.Batched = (std::string(value) == "batched");
+    }
+    else if (arg == "--scales")
+    {
+      config.Scales.clear();
+
+      std::string list = value;
+
+      size_t pos = 0;
+      while (pos < list.length())
+      {
+        size_t comma = list.find(',', pos);
+        if (comma == std::string::npos)
+        {
+          comma = list.length();
+        }
+
+        double scale = std::atof(list.substr(pos, comma - pos).data());
+        if (scale > 0.0)
+        {
+          config.Scales.push_back(scale);
+        }
+
+        pos = comma + 1;
+      }
+
+      if (config.Scales.empty())
+      {
+        config.Scales.push_back(1.0);
+      }
+    }
+    else
+    {
+      printf("Unknown option %s\n", arg.data());
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// =============================================================================
+
+std::string MakeString(size_t index, size_t length)
+{
+  std::string s;
+  s.reserve(length);
+
+  const std::string& source = LoremIpsum[index % LoremIpsum.size()];
+
+  while (s.length() < length)
+  {
+    s += source;
+    s += ' ';
+  }
+
+  s.resize(length);
+
+  return s;
+}
+
+// =============================================================================
+
+double Percentile(const std::vector<double>& sorted, double p)
+{
+  size_t ind = (size_t)(p * (double)(sorted.size() - 1) + 0.5);
+  return sorted[ind];
+}
+
+// =============================================================================
+
+int main(int argc, char* argv[])
+{
+  Config config;
+  if (not ParseArgs(argc, argv, config))
+  {
+    return 1;
+  }
+
+  Headless headless;
+  if (not InitHeadless(headless))
+  {
+    return 1;
+  }
+
+  SDL_Renderer* r = headless.Renderer;
+
+  if (not IF::Instance().Init(r))
+  {
+    return 1;
+  }
+
+  //
+  // Layout itself is measured, not replay of cached layouts.
+  //
+  IF::Instance().SetLayoutCache(0);
+
+  int numStatic = (int)(config.Strings * config.Static + 0.5);
+
+  std::vector<std::string> strings;
+  for (int i = 0; i < config.Strings; i++)
+  {
+    strings.push_back(MakeString(i, config.Length));
+  }
+
+  std::vector<double> frameTimes;
+  frameTimes.reserve(config.Frames);
+
+  for (int frame = 0; frame < config.Frames; frame++)
+  {
+    uint64_t before = SDL_GetPerformanceCounter();
+
+    SDL_RenderClear(r);
+
+    if (config.Batched)
+    {
+      IF::Instance().BeginBatch();
+    }
+
+    int lineHeight = IF::Instance().GlyphHeight() + 1;
+
+    for (int i = 0; i < config.Strings; i++)
+    {
+      double scale = config.Scales[i % config.Scales.size()];
+
+      uint32_t color = Palette[(i % config.Colors) % Palette.size()];
+
+      int x = (i % 2) * (kTargetWidth / 2);
+      int y = ((i / 2) * lineHeight) % kTargetHeight;
+
+      if (i < numStatic)
+      {
+        IF::Instance().Print(x, y,
+                             strings[i],
+                             color,
+                             IF::TextAlignment::LEFT,
+                             scale);
+      }
+      else
+      {
+        IF::Instance().Printf(x, y,
+                              IF::TextParams::Set(color,
+                                                  IF::TextAlignment::LEFT,
+                                                  scale),
+                              "%d: %.*s",
+                              frame,
+                              (int)config.Length,
+                              strings[i].data());
+      }
+    }
+
+    if (config.Batched)
+    {
+      IF::Instance().Flush();
+    }
+
+    SDL_RenderPresent(r);
+
+    uint64_t after = SDL_GetPerformanceCounter();
+
+    frameTimes.push_back(ToSeconds(after - before) * 1e3);
+  }
+
+  std::vector<double> sorted = frameTimes;
+  std::sort(sorted.begin(), sorted.end());
+
+  double sum = 0.0;
+  for (double t : frameTimes)
+  {
+    sum += t;
+  }
+
+  printf("mode=%s frames=%d strings=%d length=%zu colors=%d static=%.2f\n",
+         config.Batched ? "batched" : "immediate",
+         config.Frames,
+         config.Strings,
+         config.Length,
+         config.Colors,
+         config.Static);
+
+  printf("frame time, ms: avg %.3f  p50 %.3f  p90 %.3f  p99 %.3f  max %.3f\n",
+         sum / frameTimes.size(),
+         Percentile(sorted, 0.50),
+         Percentile(sorted, 0.90),
+         Percentile(sorted, 0.99),
+         sorted.back());
+
+  ShutdownHeadless(headless);
+
+  return 0;
+}
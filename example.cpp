@@ -1,4 +1,11 @@
 #include "instant-font.h"
+#include "instant-font-hexview.h"
+#include "instant-font-console.h"
+#include "instant-font-counter.h"
+
+#ifdef INSTANT_FONT_ALLOC_CHECK
+INSTANT_FONT_ALLOC_HOOK
+#endif
 
 bool IsRunning = true;
 
@@ -18,6 +25,8 @@ const std::vector<std::string> LoremIpsum =
 
 void HandleEvent(const SDL_Event& evt)
 {
+  IF::Instance().HandleRenderEvent(evt);
+
   const uint8_t* kb = SDL_GetKeyboardState(nullptr);
   if (kb[SDL_SCANCODE_ESCAPE])
   {
@@ -61,12 +70,50 @@ int main(int argc, char* argv[])
     return 1;
   }
 
+  std::string hexSample;
+  for (auto& line : LoremIpsum)
+  {
+    hexSample += line;
+  }
+
+  IFHexView hexView;
+  hexView.SetData(hexSample.data(), hexSample.length());
+
+  IFConsole console(100, 80);
+  console.Write("\x1b[1mmain.cpp:12:5: \x1b[1;31merror: \x1b[0m"
+                "expected ';' after expression\n"
+                "\x1b[1mmain.cpp:7:9: \x1b[1;35mwarning: \x1b[0m"
+                "unused variable 'x'\n"
+                "\x1b[38;5;208m256 colors\x1b[0m and "
+                "\x1b[38;2;80;160;255mtruecolor\x1b[0m\n");
+
+  IFCounter frameTime("Frame ms ", 5, 1);
+  frameTime.SetPosition(500, 280);
+  frameTime.SetColor(0x00FF00);
+
+  //
+  // Heart icon in place of a control character, printed inline.
+  //
+  IF::Instance().SetGlyph('\x01', { 0, 198, 495, 511, 511, 254, 124, 56, 16 });
+
   SDL_Event evt;
 
   uint64_t dt = 0;
 
+  size_t frame = 0;
+
   while (IsRunning)
   {
+#ifdef INSTANT_FONT_ALLOC_CHECK
+    //
+    // Every buffer has grown to its size during the first frames.
+    //
+    if (frame == 10)
+    {
+      IF::Instance().ExpectNoAllocations(true);
+    }
+#endif
+
     uint64_t before = SDL_GetTicks();
 
     while (SDL_PollEvent(&evt))
@@ -88,7 +135,7 @@ int main(int argc, char* argv[])
 
     SDL_SetRenderDrawColor(r, 0, 0, 0, 255);
 
-    IF::Instance().ShowFontBitmap();
+    IF::Instance().ShowFontBitmap(1);
 
     int lineInd = 0;
     for (auto& line : LoremIpsum)
@@ -97,8 +144,10 @@ int main(int argc, char* argv[])
       lineInd += 10;
     }
 
+    IF::Instance().Print(650, 280, "\x01 x 3", 0xFF4040);
     IF::Instance().Print(650, 290, "Simple print");
     IF::Instance().Print(650, 300, "Colored print", 0xFFFF00);
+    IF::Instance().Print(650, 310, "Translucent print", 0x80FFFFFF);
 
     IF::Instance().Print(780, 320,
                          "Scale = 1.5",
@@ -143,15 +192,58 @@ int main(int argc, char* argv[])
                          2.0);
 
 
+    IF::Instance().Print(570, 500,
+                         "Outlined",
+                         0xFFFF00,
+                         IF::TextAlignment::LEFT,
+                         2.0,
+                         IF::TextEffect::OUTLINE);
+
+    IF::Instance().Print(570, 500,
+                         "Shadow",
+                         0xFFFFFF,
+                         IF::TextAlignment::RIGHT,
+                         2.0,
+                         IF::TextEffect::SHADOW);
+
+    IF::Instance().Print(780, 380,
+                         "Bold",
+                         0xFFFFFF,
+                         IF::TextAlignment::RIGHT,
+                         2.0,
+                         IF::TextEffect::NONE,
+                         IF::TextStyle::BOLD);
+
+    IF::Instance().Print(780, 400,
+                         "Italic",
+                         0xFFFFFF,
+                         IF::TextAlignment::RIGHT,
+                         2.0,
+                         IF::TextEffect::NONE,
+                         IF::TextStyle::ITALIC);
+
     IF::Instance().Print(400, 520,
                          "Non-printable: Дbё",
                          0xFFFFFF,
                          IF::TextAlignment::LEFT,
                          2.0);
 
+    IF::Instance().PrintMarkup(0, 280,
+                               "{#FF0000}{b}ERROR{/}: markup "
+                               "{#00FF00}colors{/} and {i}styles{/}");
+
+    console.Draw(0, 200, 8);
+
+    hexView.Draw(0, 548, 5);
+
+    frameTime.Set((double)dt);
+    frameTime.Draw();
+
     SDL_RenderPresent(r);
 
     dt = SDL_GetTicks() - before;
+
+    frame++;
   }
 
   SDL_Log("Goodbye!");
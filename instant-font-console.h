@@ -0,0 +1,731 @@
+#ifndef INSTANT_FONT_CONSOLE_H
+#define INSTANT_FONT_CONSOLE_H
+
+#include "instant-font.h"
+
+//
+// Scrollback panel for output of command line programs on top of IF.
+//
+// Write() takes raw bytes as they come from a pipe (chunks may end
+// in the middle of an escape sequence) and runs them through ANSI state
+// machine: SGR sequences become color / style runs of the current line,
+// other escape sequences are dropped. Printable text is appended
+// in whole spans, so cost per byte is close to a memcpy.
+//
+// Supported SGR: reset, bold, italic, 8 / 16 colors, 256-color palette
+// (38;5;n or 38:5:n) and truecolor (38;2;r;g;b, 38:2::r:g:b or
+// 38:2:r:g:b). Background colors are parsed and ignored. Carriage return
+// without line feed starts the line over, which is enough for progress
+// bars. Control characters inside escape sequences are executed, as
+// terminals do.
+//
+class IFConsole
+{
+  public:
+    // -------------------------------------------------------------------------
+
+    //
+    // Keeps up to maxLines lines, the oldest ones are dropped.
+    // Lines longer than columns are wrapped (0 - no wrapping).
+    //
+    explicit IFConsole(size_t maxLines = 1000, size_t columns = 0)
+      : _maxLines(maxLines ? maxLines : 1),
+        _columns(columns)
+    {
+      Clear();
+    }
+
+    // -------------------------------------------------------------------------
+
+    void SetDefaultColor(uint32_t color)
+    {
+      _defaultColor = color;
+      _current.Color = color;
+    }
+
+    // -------------------------------------------------------------------------
+
+    void Clear()
+    {
+      _first  = 0;
+      _count  = 0;
+      _scroll = 0;
+
+      _state         = State::GROUND;
+      _numParams     = 0;
+      _pendingReturn = false;
+
+      _current = { _defaultColor, false, false };
+
+      NewLine();
+    }
+
+    // -------------------------------------------------------------------------
+
+    void Write(const std::string& text)
+    {
+      Write(text.data(), text.length());
+    }
+
+    // -------------------------------------------------------------------------
+
+    void Write(const char* data, size_t size)
+    {
+      const char* p   = data;
+      const char* end = data + size;
+
+      while (p < end)
+      {
+        if (_state == State::GROUND)
+        {
+          //
+          // Fast path: span of plain ASCII is appended at once.
+          //
+          const char* span = p;
+
+          while (p < end and (uint8_t)*p >= 0x20 and (uint8_t)*p < 0x7F)
+          {
+            p++;
+          }
+
+          if (p > span)
+          {
+            AppendText(span, p - span);
+          }
+
+          if (p < end)
+          {
+            Control((uint8_t)*p);
+            p++;
+          }
+        }
+        else
+        {
+          Escape((uint8_t)*p);
+          p++;
+        }
+      }
+    }
+
+    // -------------------------------------------------------------------------
+
+    size_t TotalLines() const
+    {
+      return _count;
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Positive values scroll back into history, negative - towards
+    // the newest output. Zero keeps the last line at the bottom.
+    //
+    void Scroll(int64_t lines)
+    {
+      int64_t scroll = (int64_t)_scroll + lines;
+
+      _scroll = (size_t)std::max<int64_t>(0,
+                  std::min<int64_t>(scroll, (int64_t)_count - 1));
+    }
+
+    // -------------------------------------------------------------------------
+
+    void Draw(int x, int y, size_t visibleRows, double scaleFactor = 1.0)
+    {
+      IF& font = IF::Instance();
+
+      size_t last = _count - _scroll;
+      size_t rows = std::min(visibleRows, last);
+
+      float scale   = scaleFactor;
+      float advance = font.GlyphWidth()  * scale;
+      float lineH   = font.GlyphHeight() * scale;
+
+      bool ownBatch = not font.IsBatching();
+      if (ownBatch)
+      {
+        font.BeginBatch();
+      }
+
+      for (size_t row = 0; row < rows; row++)
+      {
+        const Line& line = GetLine(last - rows + row);
+
+        float py = y + row * lineH;
+
+        for (size_t i = 0; i < line.Runs.size(); i++)
+        {
+          const Run& run = line.Runs[i];
+
+          size_t runEnd = (i + 1 < line.Runs.size())
+                        ? line.Runs[i + 1].Start
+                        : line.Text.length();
+
+          if (runEnd <= run.Start)
+          {
+            continue;
+          }
+
+          SDL_Vertex* out = font.BeginGlyphs(runEnd - run.Start,
+                                             run.Attr.Color,
+                                             run.Attr.Style());
+
+          if (out == nullptr)
+          {
+            continue;
+          }
+
+          float px = x + run.Start * advance;
+
+          for (size_t col = run.Start; col < runEnd; col++)
+          {
+            out = font.PutGlyph(out, px, py, scale, line.Text[col]);
+            px += advance;
+          }
+
+          font.EndGlyphs(out);
+        }
+      }
+
+      if (ownBatch)
+      {
+        font.Flush();
+      }
+    }
+
+    // -------------------------------------------------------------------------
+
+  private:
+    enum class State
+    {
+      GROUND = 0,
+      ESCAPE,
+      CSI,
+      OSC,
+      OSC_ESCAPE
+    };
+
+    // -------------------------------------------------------------------------
+
+    struct Attribute
+    {
+      uint32_t Color;
+      bool     Bold;
+      bool     Italic;
+
+      IF::TextStyle Style() const
+      {
+        return (IF::TextStyle)((Bold ? 1 : 0) | (Italic ? 2 : 0));
+      }
+
+      bool operator==(const Attribute& other) const
+      {
+        return Color  == other.Color
+           and Bold   == other.Bold
+           and Italic == other.Italic;
+      }
+    };
+
+    // -------------------------------------------------------------------------
+
+    struct Run
+    {
+      size_t    Start;
+      Attribute Attr;
+    };
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Line objects are reused when scrollback wraps around,
+    // so steady output doesn't allocate.
+    //
+    struct Line
+    {
+      std::string      Text;
+      std::vector<Run> Runs;
+    };
+
+    // -------------------------------------------------------------------------
+
+    Line& GetLine(size_t index)
+    {
+      return _lines[(_first + index) % _maxLines];
+    }
+
+    // -------------------------------------------------------------------------
+
+    Line& CurrentLine()
+    {
+      return GetLine(_count - 1);
+    }
+
+    // -------------------------------------------------------------------------
+
+    void NewLine()
+    {
+      if (_count < _maxLines)
+      {
+        if (_lines.size() < _maxLines)
+        {
+          _lines.emplace_back();
+        }
+
+        _count++;
+      }
+      else
+      {
+        _first = (_first + 1) % _maxLines;
+      }
+
+      Line& line = CurrentLine();
+
+      line.Text.clear();
+      line.Runs.clear();
+      line.Runs.push_back({ 0, _current });
+    }
+
+    // -------------------------------------------------------------------------
+
+    void ResetLine()
+    {
+      Line& line = CurrentLine();
+
+      line.Text.clear();
+      line.Runs.clear();
+      line.Runs.push_back({ 0, _current });
+    }
+
+    // -------------------------------------------------------------------------
+
+    void AppendText(const char* text, size_t length)
+    {
+      if (_pendingReturn)
+      {
+        _pendingReturn = false;
+        ResetLine();
+      }
+
+      while (length > 0)
+      {
+        Line& line = CurrentLine();
+
+        size_t room = length;
+
+        if (_columns != 0)
+        {
+          if (line.Text.length() >= _columns)
+          {
+            NewLine();
+            continue;
+          }
+
+          room = std::min(length, _columns - line.Text.length());
+        }
+
+        line.Text.append(text, room);
+
+        text   += room;
+        length -= room;
+      }
+    }
+
+    // -------------------------------------------------------------------------
+
+    void SetAttribute(const Attribute& attr)
+    {
+      _current = attr;
+
+      Line& line = CurrentLine();
+
+      Run& last = line.Runs.back();
+
+      if (last.Start == line.Text.length())
+      {
+        last.Attr = attr;
+      }
+      else if (not (last.Attr == attr))
+      {
+        line.Runs.push_back({ line.Text.length(), attr });
+      }
+    }
+
+    // -------------------------------------------------------------------------
+
+    void Control(uint8_t c)
+    {
+      switch (c)
+      {
+        // --------------------------
+        case '\n':
+          _pendingReturn = false;
+          NewLine();
+          break;
+        // --------------------------
+        case '\r':
+          _pendingReturn = true;
+          break;
+        // --------------------------
+        case '\t':
+        {
+          size_t column = _pendingReturn ? 0 : CurrentLine().Text.length();
+          size_t spaces = kTabWidth - column % kTabWidth;
+          AppendText("        ", spaces);
+        }
+        break;
+        // --------------------------
+        case '\b':
+        {
+          Line& line = CurrentLine();
+          if (not line.Text.empty())
+          {
+            line.Text.pop_back();
+
+            while (line.Runs.size() > 1
+               and line.Runs.back().Start > line.Text.length())
+            {
+              line.Runs.pop_back();
+            }
+          }
+        }
+        break;
+        // --------------------------
+        case 0x1B:
+          _state = State::ESCAPE;
+          break;
+        // --------------------------
+        default:
+          //
+          // UTF-8 sequence takes one cell: lead byte is shown
+          // as a placeholder, continuation bytes are skipped.
+          // Other control characters are ignored.
+          //
+          if (c >= 0xC0)
+          {
+            AppendText("?", 1);
+          }
+          break;
+        // --------------------------
+      }
+    }
+
+    // -------------------------------------------------------------------------
+
+    void Escape(uint8_t c)
+    {
+      //
+      // C0 controls are executed in the middle of a sequence, ESC
+      // starts a new one, CAN and SUB cancel it. Strings (OSC) only
+      // end on BEL or ST.
+      //
+      if (c < 0x20 and (_state == State::ESCAPE or _state == State::CSI))
+      {
+        if (c == 0x18 or c == 0x1A)
+        {
+          _state = State::GROUND;
+        }
+        else
+        {
+          Control(c);
+        }
+
+        return;
+      }
+
+      switch (_state)
+      {
+        // --------------------------
+        case State::ESCAPE:
+          if (c == '[')
+          {
+            _state     = State::CSI;
+            _numParams = 0;
+            _param     = 0;
+            _subParam  = false;
+            _private   = false;
+          }
+          else if (c == ']')
+          {
+            _state = State::OSC;
+          }
+          else if (c > 0x2F)
+          {
+            //
+            // Intermediate bytes (like '(' in ESC ( B) keep us here
+            // until the final byte.
+            //
+            _state = State::GROUND;
+          }
+          break;
+        // --------------------------
+        case State::CSI:
+          if (c >= '0' and c <= '9')
+          {
+            _param = std::min<uint32_t>(_param * 10 + (c - '0'), 0xFFFF);
+          }
+          else if (c == ';' or c == ':')
+          {
+            PushParam();
+
+            _subParam = (c == ':');
+          }
+          else if (c >= 0x3C and c <= 0x3F)
+          {
+            _private = true;
+          }
+          else if (c >= 0x40 and c <= 0x7E)
+          {
+            PushParam();
+
+            if (c == 'm' and not _private)
+            {
+              SelectGraphicRendition();
+            }
+
+            _state = State::GROUND;
+          }
+          break;
+        // --------------------------
+        case State::OSC:
+          if (c == 0x07)
+          {
+            _state = State::GROUND;
+          }
+          else if (c == 0x1B)
+          {
+            _state = State::OSC_ESCAPE;
+          }
+          break;
+        // --------------------------
+        case State::OSC_ESCAPE:
+          _state = (c == '\\') ? State::GROUND : State::OSC;
+          break;
+        // --------------------------
+        default:
+          _state = State::GROUND;
+          break;
+        // --------------------------
+      }
+    }
+
+    // -------------------------------------------------------------------------
+
+    void PushParam()
+    {
+      if (_numParams < kMaxParams)
+      {
+        _subParams[_numParams] = _subParam;
+        _params[_numParams++]  = _param;
+      }
+
+      _param    = 0;
+      _subParam = false;
+    }
+
+    // -------------------------------------------------------------------------
+
+    void SelectGraphicRendition()
+    {
+      Attribute attr = _current;
+
+      for (size_t i = 0; i < _numParams; i++)
+      {
+        uint32_t code = _params[i];
+
+        //
+        // Colon separated sub-parameters belong to the code before
+        // them and are never taken for codes of their own.
+        //
+        size_t groupEnd = i + 1;
+
+        while (groupEnd < _numParams and _subParams[groupEnd])
+        {
+          groupEnd++;
+        }
+
+        if (code == 0)
+        {
+          attr = { _defaultColor, false, false };
+        }
+        else if (code == 1)
+        {
+          attr.Bold = true;
+        }
+        else if (code == 3)
+        {
+          attr.Italic = true;
+        }
+        else if (code == 22)
+        {
+          attr.Bold = false;
+        }
+        else if (code == 23)
+        {
+          attr.Italic = false;
+        }
+        else if (code >= 30 and code <= 37)
+        {
+          attr.Color = kPalette16[code - 30];
+        }
+        else if (code >= 90 and code <= 97)
+        {
+          attr.Color = kPalette16[code - 90 + 8];
+        }
+        else if (code == 39)
+        {
+          attr.Color = _defaultColor;
+        }
+        else if (code == 38 or code == 48)
+        {
+          uint32_t color = 0;
+
+          if (groupEnd > i + 1)
+          {
+            SubParamColor(i + 1, groupEnd, color);
+          }
+          else
+          {
+            i += ExtendedColor(i + 1, color);
+          }
+
+          if (code == 38)
+          {
+            attr.Color = color;
+          }
+        }
+
+        i = std::max(i, groupEnd - 1);
+      }
+
+      SetAttribute(attr);
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Parses "5;n" or "2;r;g;b" starting at given parameter.
+    // Returns number of parameters consumed.
+    //
+    size_t ExtendedColor(size_t from, uint32_t& color) const
+    {
+      if (from >= _numParams)
+      {
+        return 0;
+      }
+
+      if (_params[from] == 5 and from + 1 < _numParams)
+      {
+        color = Palette256(_params[from + 1] & 0xFF);
+        return 2;
+      }
+
+      if (_params[from] == 2 and from + 3 < _numParams)
+      {
+        color = ((_params[from + 1] & 0xFF) << 16)
+              | ((_params[from + 2] & 0xFF) << 8)
+              |  (_params[from + 3] & 0xFF);
+        return 4;
+      }
+
+      return 1;
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Parses colon form "5:n", "2:r:g:b" or "2:id:r:g:b" (ITU T.416,
+    // with color space id, usually empty) from parameters [from, end).
+    //
+    void SubParamColor(size_t from, size_t end, uint32_t& color) const
+    {
+      size_t count = end - from;
+
+      if (_params[from] == 5 and count >= 2)
+      {
+        color = Palette256(_params[from + 1] & 0xFF);
+      }
+      else if (_params[from] == 2 and count >= 4)
+      {
+        size_t rgb = (count >= 5) ? from + 2 : from + 1;
+
+        color = ((_params[rgb]     & 0xFF) << 16)
+              | ((_params[rgb + 1] & 0xFF) << 8)
+              |  (_params[rgb + 2] & 0xFF);
+      }
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // xterm 256 color palette: 16 system colors, 6x6x6 cube, 24 grays.
+    //
+    static uint32_t Palette256(uint32_t index)
+    {
+      if (index < 16)
+      {
+        return kPalette16[index];
+      }
+
+      if (index < 232)
+      {
+        index -= 16;
+
+        uint32_t r = kCubeLevels[index / 36];
+        uint32_t g = kCubeLevels[(index / 6) % 6];
+        uint32_t b = kCubeLevels[index % 6];
+
+        return (r << 16) | (g << 8) | b;
+      }
+
+      uint32_t gray = 8 + (index - 232) * 10;
+
+      return (gray << 16) | (gray << 8) | gray;
+    }
+
+    // -------------------------------------------------------------------------
+
+    static constexpr size_t kTabWidth  = 8;
+    static constexpr size_t kMaxParams = 16;
+
+    static constexpr uint32_t kPalette16[16] =
+    {
+      0x000000, 0xCD0000, 0x00CD00, 0xCDCD00,
+      0x0000EE, 0xCD00CD, 0x00CDCD, 0xE5E5E5,
+      0x7F7F7F, 0xFF0000, 0x00FF00, 0xFFFF00,
+      0x5C5CFF, 0xFF00FF, 0x00FFFF, 0xFFFFFF
+    };
+
+    static constexpr uint32_t kCubeLevels[6] =
+    {
+      0x00, 0x5F, 0x87, 0xAF, 0xD7, 0xFF
+    };
+
+    size_t _maxLines = 1000;
+    size_t _columns  = 0;
+
+    std::vector<Line> _lines;
+
+    size_t _first  = 0;
+    size_t _count  = 0;
+    size_t _scroll = 0;
+
+    uint32_t  _defaultColor = 0xFFFFFF;
+    Attribute _current      = { 0xFFFFFF, false, false };
+
+    State _state = State::GROUND;
+
+    //
+    // Parameters of the current CSI. Sub-parameters are the ones
+    // that followed ':' instead of ';'.
+    //
+    uint32_t _params[kMaxParams];
+    bool     _subParams[kMaxParams];
+    size_t   _numParams = 0;
+    uint32_t _param     = 0;
+    bool     _subParam  = false;
+    bool     _private   = false;
+
+    bool _pendingReturn = false;
+};
+
+#endif
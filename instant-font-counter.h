@@ -0,0 +1,334 @@
+#ifndef INSTANT_FONT_COUNTER_H
+#define INSTANT_FONT_COUNTER_H
+
+#include "instant-font.h"
+
+//
+// Live numeric display on top of IF: a label followed by a fixed field
+// of digits, right aligned, optionally with a decimal point.
+//
+// Quads are laid out once. Set() walks the digits of the new value and
+// copies prepared digit quads into the slots whose digit changed, there
+// is no formatting, string or layout involved. Draw() copies prepared
+// quads into the batch.
+//
+class IFCounter
+{
+  public:
+    // -------------------------------------------------------------------------
+
+    static constexpr size_t kMaxDigits = 19;
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Field of given number of digits, last decimals of them
+    // after the decimal point. Up to kMaxDigits, more don't fit
+    // into uint64_t.
+    //
+    IFCounter(const std::string& label, size_t digits, size_t decimals = 0)
+      : _label(label),
+        _digits(std::min(std::max(digits, (size_t)1), kMaxDigits)),
+        _decimals(std::min(decimals, _digits - 1))
+    {
+      _maxValue = 1;
+
+      for (size_t i = 0; i < _digits; i++)
+      {
+        _maxValue *= 10;
+      }
+
+      _maxValue--;
+
+      _fixedScale = 1.0;
+
+      for (size_t i = 0; i < _decimals; i++)
+      {
+        _fixedScale *= 10.0;
+      }
+    }
+
+    // -------------------------------------------------------------------------
+
+    void SetPosition(int x, int y, double scaleFactor = 1.0)
+    {
+      _x     = x;
+      _y     = y;
+      _scale = scaleFactor;
+      _built = false;
+    }
+
+    // -------------------------------------------------------------------------
+
+    void SetColor(uint32_t color)
+    {
+      _color = color;
+      _built = false;
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Show leading zeroes instead of blanks.
+    //
+    void SetZeroPadding(bool enabled)
+    {
+      _zeroPadding = enabled;
+      _built       = false;
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Lays quads out again on next Draw(), needed after
+    // the font was changed.
+    //
+    void Rebuild()
+    {
+      _built = false;
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Values that don't fit into the field show as all nines.
+    //
+    void Set(uint64_t value)
+    {
+      value = std::min(value, _maxValue);
+
+      if (value == _value)
+      {
+        return;
+      }
+
+      _value = value;
+
+      if (_built)
+      {
+        UpdateDigits(false);
+      }
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Rounded to the number of decimals, negative values and NaN show
+    // as zero. Clamped before conversion, which is undefined for values
+    // out of uint64_t range.
+    //
+    void Set(double value)
+    {
+      double fixed = std::round(value * _fixedScale);
+
+      if (not (fixed > 0.0))
+      {
+        Set((uint64_t)0);
+      }
+      else if (fixed >= (double)_maxValue)
+      {
+        Set(_maxValue);
+      }
+      else
+      {
+        Set((uint64_t)fixed);
+      }
+    }
+
+    // -------------------------------------------------------------------------
+
+    uint64_t Value() const
+    {
+      return _value;
+    }
+
+    // -------------------------------------------------------------------------
+
+    void Draw()
+    {
+      IF& font = IF::Instance();
+
+      //
+      // Quads are laid out only once the font is there to take them from.
+      //
+      if (not font.IsInitialized())
+      {
+        return;
+      }
+
+      if (not _built)
+      {
+        Build();
+      }
+
+      SDL_Vertex* out = font.BeginGlyphs(_quads.size() / 4, _color);
+
+      if (out == nullptr)
+      {
+        return;
+      }
+
+      std::memcpy(out, _quads.data(), _quads.size() * sizeof(SDL_Vertex));
+
+      font.EndGlyphs(out + _quads.size());
+    }
+
+    // -------------------------------------------------------------------------
+
+  private:
+    // -------------------------------------------------------------------------
+
+    //
+    // Index of blank in _glyphQuads after the ten digits.
+    //
+    static constexpr uint8_t kBlank = 10;
+
+    // -------------------------------------------------------------------------
+
+    void Build()
+    {
+      IF& font = IF::Instance();
+
+      float scale   = _scale;
+      float advance = font.GlyphWidth() * scale;
+
+      for (uint8_t glyph = 0; glyph <= kBlank; glyph++)
+      {
+        uint8_t c = (glyph == kBlank) ? ' ' : '0' + glyph;
+
+        font.GlyphQuad(_glyphQuads[glyph], 0.0f, 0.0f, scale, c, _color);
+      }
+
+      _quads.clear();
+      _slots.resize(_digits);
+      _cells.resize(_digits);
+      _shown.assign(_digits, kBlank);
+
+      float px = _x;
+      float py = _y;
+
+      for (char c : _label)
+      {
+        if (c != ' ')
+        {
+          AddQuad(px, py, c);
+        }
+
+        px += advance;
+      }
+
+      //
+      // Slots are numbered from the least significant digit.
+      //
+      for (size_t i = 0; i < _digits; i++)
+      {
+        if (_decimals != 0 and i == _digits - _decimals)
+        {
+          AddQuad(px, py, '.');
+          px += advance;
+        }
+
+        _slots[_digits - 1 - i] = _quads.size();
+        _cells[_digits - 1 - i] = { px, py };
+
+        AddQuad(px, py, ' ');
+        px += advance;
+      }
+
+      _built = true;
+
+      UpdateDigits(true);
+    }
+
+    // -------------------------------------------------------------------------
+
+    void AddQuad(float x, float y, uint8_t c)
+    {
+      size_t at = _quads.size();
+
+      _quads.resize(at + 4);
+
+      IF::Instance().GlyphQuad(&_quads[at], x, y, _scale, c, _color);
+    }
+
+    // -------------------------------------------------------------------------
+
+    void UpdateDigits(bool all)
+    {
+      uint64_t value = _value;
+
+      for (size_t i = 0; i < _digits; i++)
+      {
+        uint8_t glyph = value % 10;
+
+        //
+        // Integer part keeps at least one digit.
+        //
+        if (value == 0 and i > _decimals and not _zeroPadding)
+        {
+          glyph = kBlank;
+        }
+
+        value /= 10;
+
+        if (glyph == _shown[i] and not all)
+        {
+          continue;
+        }
+
+        _shown[i] = glyph;
+
+        SDL_Vertex* quad = &_quads[_slots[i]];
+
+        for (size_t v = 0; v < 4; v++)
+        {
+          quad[v] = _glyphQuads[glyph][v];
+
+          quad[v].position.x += _cells[i].x;
+          quad[v].position.y += _cells[i].y;
+        }
+      }
+    }
+
+    // -------------------------------------------------------------------------
+
+    std::string _label;
+
+    size_t _digits   = 1;
+    size_t _decimals = 0;
+
+    uint64_t _value    = 0;
+    uint64_t _maxValue = 9;
+
+    double _fixedScale = 1.0;
+
+    int      _x           = 0;
+    int      _y           = 0;
+    double   _scale       = 1.0;
+    uint32_t _color       = 0xFFFFFF;
+    bool     _zeroPadding = false;
+
+    bool _built = false;
+
+    //
+    // Label quads first, then digit slots (and decimal point).
+    //
+    std::vector<SDL_Vertex> _quads;
+
+    //
+    // First vertex of every digit slot, its cell position and glyph
+    // it shows.
+    //
+    std::vector<size_t>     _slots;
+    std::vector<SDL_FPoint> _cells;
+    std::vector<uint8_t>    _shown;
+
+    //
+    // Quads of digits and blank relative to the cell. Whole quads
+    // are copied: digits taken from a fallback font differ in size
+    // and offset, not only in texture coordinates.
+    //
+    SDL_Vertex _glyphQuads[kBlank + 1][4];
+};
+
+#endif
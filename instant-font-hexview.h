@@ -0,0 +1,252 @@
+#ifndef INSTANT_FONT_HEXVIEW_H
+#define INSTANT_FONT_HEXVIEW_H
+
+#include "instant-font.h"
+
+//
+// Hex viewer on top of IF.
+//
+// Renders address, hex and ASCII columns of a memory region straight
+// into glyph quads: bytes go through nibble and printable tables,
+// there is no snprintf or string building involved. Only visible rows
+// are processed, so size of the region doesn't matter.
+//
+class IFHexView
+{
+  public:
+    // -------------------------------------------------------------------------
+
+    struct Colors
+    {
+      uint32_t Address = 0x888888;
+      uint32_t Hex     = 0xFFFFFF;
+      uint32_t Ascii   = 0x00FF88;
+    };
+
+    // -------------------------------------------------------------------------
+
+    void SetData(const void* data, size_t size, uint64_t baseAddress = 0)
+    {
+      _data        = (const uint8_t*)data;
+      _size        = size;
+      _baseAddress = baseAddress;
+
+      uint64_t lastAddress = baseAddress + (size ? size - 1 : 0);
+      _addressDigits = (lastAddress > 0xFFFFFFFF) ? 16 : 8;
+
+      SetTopRow(_topRow);
+    }
+
+    // -------------------------------------------------------------------------
+
+    void SetBytesPerRow(size_t bytesPerRow)
+    {
+      _bytesPerRow = (bytesPerRow == 0) ? 1 : bytesPerRow;
+      SetTopRow(_topRow);
+    }
+
+    // -------------------------------------------------------------------------
+
+    void SetColors(const Colors& colors)
+    {
+      _colors = colors;
+    }
+
+    // -------------------------------------------------------------------------
+
+    size_t TotalRows() const
+    {
+      return (_size + _bytesPerRow - 1) / _bytesPerRow;
+    }
+
+    // -------------------------------------------------------------------------
+
+    size_t TopRow() const
+    {
+      return _topRow;
+    }
+
+    // -------------------------------------------------------------------------
+
+    void SetTopRow(size_t row)
+    {
+      size_t total = TotalRows();
+      _topRow = (total == 0) ? 0 : std::min(row, total - 1);
+    }
+
+    // -------------------------------------------------------------------------
+
+    void Scroll(int64_t rows)
+    {
+      if (rows < 0 and (size_t)(-rows) > _topRow)
+      {
+        SetTopRow(0);
+      }
+      else
+      {
+        SetTopRow(_topRow + rows);
+      }
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Width of one row in characters:
+    // "AAAAAAAA  HH HH ... HH  cccc...c"
+    //
+    size_t RowLength() const
+    {
+      return _addressDigits + 2 + _bytesPerRow * 3 + 1 + _bytesPerRow;
+    }
+
+    // -------------------------------------------------------------------------
+
+    void Draw(int x, int y, size_t visibleRows, double scaleFactor = 1.0)
+    {
+      IF& font = IF::Instance();
+
+      if (_data == nullptr or _topRow >= TotalRows())
+      {
+        return;
+      }
+
+      size_t rows = std::min(visibleRows, TotalRows() - _topRow);
+
+      float scale   = scaleFactor;
+      float advance = font.GlyphWidth()  * scale;
+      float lineH   = font.GlyphHeight() * scale;
+
+      float hexX   = x + (_addressDigits + 2) * advance;
+      float asciiX = hexX + (_bytesPerRow * 3 + 1) * advance;
+
+      //
+      // Every column is a single run of one color, and the whole view
+      // goes out as one draw call unless caller already batches.
+      //
+      bool ownBatch = not font.IsBatching();
+      if (ownBatch)
+      {
+        font.BeginBatch();
+      }
+
+      SDL_Vertex* out = font.BeginGlyphs(rows * _addressDigits,
+                                         _colors.Address);
+
+      if (out == nullptr)
+      {
+        if (ownBatch)
+        {
+          font.Flush();
+        }
+
+        return;
+      }
+
+      for (size_t row = 0; row < rows; row++)
+      {
+        uint64_t address = _baseAddress + (_topRow + row) * _bytesPerRow;
+
+        float py = y + row * lineH;
+        float px = x + (_addressDigits - 1) * advance;
+
+        for (size_t digit = 0; digit < _addressDigits; digit++)
+        {
+          out = font.PutGlyph(out, px, py, scale, kHexDigits[address & 0xF]);
+
+          address >>= 4;
+          px -= advance;
+        }
+      }
+
+      font.EndGlyphs(out);
+
+      out = font.BeginGlyphs(rows * _bytesPerRow * 2, _colors.Hex);
+
+      for (size_t row = 0; row < rows; row++)
+      {
+        const uint8_t* bytes = RowData(_topRow + row);
+
+        size_t count = RowSize(_topRow + row);
+
+        float py = y + row * lineH;
+        float px = hexX;
+
+        for (size_t i = 0; i < count; i++)
+        {
+          uint8_t hi = kHexDigits[bytes[i] >> 4];
+          uint8_t lo = kHexDigits[bytes[i] & 0xF];
+
+          out = font.PutGlyph(out, px,           py, scale, hi);
+          out = font.PutGlyph(out, px + advance, py, scale, lo);
+
+          px += advance * 3;
+        }
+      }
+
+      font.EndGlyphs(out);
+
+      out = font.BeginGlyphs(rows * _bytesPerRow, _colors.Ascii);
+
+      for (size_t row = 0; row < rows; row++)
+      {
+        const uint8_t* bytes = RowData(_topRow + row);
+
+        size_t count = RowSize(_topRow + row);
+
+        float py = y + row * lineH;
+        float px = asciiX;
+
+        for (size_t i = 0; i < count; i++)
+        {
+          uint8_t c = bytes[i];
+          if (c < 32 or c > 126)
+          {
+            c = '.';
+          }
+
+          out = font.PutGlyph(out, px, py, scale, c);
+
+          px += advance;
+        }
+      }
+
+      font.EndGlyphs(out);
+
+      if (ownBatch)
+      {
+        font.Flush();
+      }
+    }
+
+    // -------------------------------------------------------------------------
+
+  private:
+    const uint8_t* RowData(size_t row) const
+    {
+      return _data + row * _bytesPerRow;
+    }
+
+    // -------------------------------------------------------------------------
+
+    size_t RowSize(size_t row) const
+    {
+      return std::min(_bytesPerRow, _size - row * _bytesPerRow);
+    }
+
+    // -------------------------------------------------------------------------
+
+    static constexpr const char* kHexDigits = "0123456789ABCDEF";
+
+    const uint8_t* _data = nullptr;
+
+    size_t   _size        = 0;
+    uint64_t _baseAddress = 0;
+
+    size_t _bytesPerRow   = 16;
+    size_t _addressDigits = 8;
+    size_t _topRow        = 0;
+
+    Colors _colors;
+};
+
+#endif
@@ -0,0 +1,358 @@
+#ifndef INSTANT_FONT_PROFILER_H
+#define INSTANT_FONT_PROFILER_H
+
+#include "instant-font.h"
+
+//
+// Frame time and scoped timer overlay on top of IF.
+//
+// MarkFrame() once per frame records time since the previous call into
+// a ring buffer, together with what every named timer accumulated during
+// that frame. Draw() prints min / avg / p99 of the recorded history for
+// each of them with a sparkline of the latest samples drawn from block
+// glyphs of the atlas, all in the same batch as other text.
+//
+// Meant to be used from the thread that renders.
+//
+class IFProfiler
+{
+  public:
+    // -------------------------------------------------------------------------
+
+    explicit IFProfiler(size_t history = 240)
+      : _history(std::max(history, (size_t)1))
+    {
+      _series.emplace_back("frame", _history);
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Adds time to the timer of given name (created on first use)
+    // for the current frame. Name should be a string literal
+    // or otherwise outlive the profiler, "frame" is taken.
+    //
+    void AddTime(const char* name, uint64_t ticks)
+    {
+      FindSeries(name).Pending += ticks;
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Measures its own lifetime into a named timer.
+    //
+    struct Scope
+    {
+      Scope(IFProfiler& profiler, const char* name)
+        : Profiler(profiler),
+          Name(name),
+          Start(SDL_GetPerformanceCounter())
+      {
+      }
+
+      ~Scope()
+      {
+        Profiler.AddTime(Name, SDL_GetPerformanceCounter() - Start);
+      }
+
+      IFProfiler& Profiler;
+      const char* Name;
+      uint64_t    Start;
+    };
+
+    // -------------------------------------------------------------------------
+
+    void MarkFrame()
+    {
+      uint64_t now = SDL_GetPerformanceCounter();
+
+      double toMs = 1e3 / (double)SDL_GetPerformanceFrequency();
+
+      //
+      // Frame time is known from the second call on.
+      //
+      if (_lastFrame != 0)
+      {
+        _series[0].Push((float)((now - _lastFrame) * toMs));
+      }
+
+      for (size_t i = 1; i < _series.size(); i++)
+      {
+        _series[i].Push((float)(_series[i].Pending * toMs));
+        _series[i].Pending = 0;
+      }
+
+      _lastFrame = now;
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Over the whole recorded history, in milliseconds.
+    //
+    struct Summary
+    {
+      float Last = 0.0f;
+      float Min  = 0.0f;
+      float Avg  = 0.0f;
+      float P99  = 0.0f;
+      float Max  = 0.0f;
+    };
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Summary of frame times (nullptr) or of a timer.
+    // Returns false if there is no such timer or nothing was recorded.
+    //
+    bool GetSummary(const char* name, Summary& summary)
+    {
+      for (const Series& series : _series)
+      {
+        if (name == nullptr or std::strcmp(series.Name, name) == 0)
+        {
+          return Summarize(series, summary);
+        }
+      }
+
+      return false;
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Sparkline shows up to given number of latest samples,
+    // each as a bar of given width in pixels (before scaling).
+    //
+    void SetGraph(size_t columns, float barWidth = 2.0f)
+    {
+      _columns  = columns;
+      _barWidth = barWidth;
+    }
+
+    // -------------------------------------------------------------------------
+
+    void SetColors(uint32_t text, uint32_t graph)
+    {
+      _textColor  = text;
+      _graphColor = graph;
+    }
+
+    // -------------------------------------------------------------------------
+
+    void Draw(int x, int y, double scaleFactor = 1.0)
+    {
+      IF& font = IF::Instance();
+
+      if (font.GlyphWidth() == 0)
+      {
+        return;
+      }
+
+      bool ownBatch = not font.IsBatching();
+      if (ownBatch)
+      {
+        font.BeginBatch();
+      }
+
+      float scale      = scaleFactor;
+      float lineHeight = (font.GlyphHeight() + 1) * scale;
+      float graphX     = x + kTextColumns * font.GlyphWidth() * scale;
+
+      IF::TextParams params = IF::TextParams::Set(_textColor,
+                                                  IF::TextAlignment::LEFT,
+                                                  scaleFactor);
+
+      font.Printf(x, y, params, "%-10s %7s %7s %7s  ms",
+                  "", "min", "avg", "p99");
+
+      float py = y + lineHeight;
+
+      for (const Series& series : _series)
+      {
+        Summary summary;
+        if (not Summarize(series, summary))
+        {
+          continue;
+        }
+
+        font.Printf(x, py, params, "%-10.10s %7.2f %7.2f %7.2f",
+                    series.Name, summary.Min, summary.Avg, summary.P99);
+
+        DrawGraph(series, graphX, py, scale, summary.Max);
+
+        py += lineHeight;
+      }
+
+      if (ownBatch)
+      {
+        font.Flush();
+      }
+    }
+
+    // -------------------------------------------------------------------------
+
+  private:
+    // -------------------------------------------------------------------------
+
+    //
+    // Width of the readout text before the sparkline, in characters.
+    //
+    static constexpr int kTextColumns = 40;
+
+    // -------------------------------------------------------------------------
+
+    struct Series
+    {
+      Series(const char* name, size_t history)
+        : Name(name),
+          Samples(history, 0.0f)
+      {
+      }
+
+      void Push(float value)
+      {
+        Samples[Head] = value;
+
+        Head  = (Head + 1) % Samples.size();
+        Count = std::min(Count + 1, Samples.size());
+      }
+
+      //
+      // i-th of the latest n samples, oldest first.
+      //
+      float Latest(size_t n, size_t i) const
+      {
+        size_t size = Samples.size();
+        return Samples[(Head + size - n + i) % size];
+      }
+
+      const char* Name;
+
+      std::vector<float> Samples;
+
+      size_t Head  = 0;
+      size_t Count = 0;
+
+      //
+      // Ticks accumulated during the current frame.
+      //
+      uint64_t Pending = 0;
+    };
+
+    // -------------------------------------------------------------------------
+
+    Series& FindSeries(const char* name)
+    {
+      for (Series& series : _series)
+      {
+        if (series.Name == name or std::strcmp(series.Name, name) == 0)
+        {
+          return series;
+        }
+      }
+
+      _series.emplace_back(name, _history);
+
+      return _series.back();
+    }
+
+    // -------------------------------------------------------------------------
+
+    bool Summarize(const Series& series, Summary& summary)
+    {
+      size_t n = series.Count;
+      if (n == 0)
+      {
+        return false;
+      }
+
+      _sorted.resize(n);
+
+      double sum = 0.0;
+
+      for (size_t i = 0; i < n; i++)
+      {
+        _sorted[i] = series.Latest(n, i);
+        sum += _sorted[i];
+      }
+
+      summary.Last = _sorted[n - 1];
+      summary.Avg  = sum / n;
+
+      auto minMax = std::minmax_element(_sorted.begin(), _sorted.end());
+
+      summary.Min = *minMax.first;
+      summary.Max = *minMax.second;
+
+      size_t rank = (n * 99 + 99) / 100 - 1;
+
+      std::nth_element(_sorted.begin(), _sorted.begin() + rank, _sorted.end());
+
+      summary.P99 = _sorted[rank];
+
+      return true;
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Bars are scaled to the largest sample of the history.
+    //
+    void DrawGraph(const Series& series,
+                   float x, float y,
+                   float scale,
+                   float maxValue)
+    {
+      IF& font = IF::Instance();
+
+      size_t n = std::min(series.Count, _columns);
+
+      if (n == 0 or maxValue <= 0.0f)
+      {
+        return;
+      }
+
+      float barWidth = _barWidth * scale;
+
+      SDL_Vertex* out = font.BeginGlyphs(n, _graphColor);
+
+      if (out == nullptr)
+      {
+        return;
+      }
+
+      for (size_t i = 0; i < n; i++)
+      {
+        float value = series.Latest(n, i);
+
+        int level = (int)std::ceil(value / maxValue * IF::kBlockLevels);
+
+        out = font.PutBlock(out, x + i * barWidth, y, barWidth, scale, level);
+      }
+
+      font.EndGlyphs(out);
+    }
+
+    // -------------------------------------------------------------------------
+
+    size_t _history;
+
+    //
+    // Frame times first, then timers in order of first use.
+    //
+    std::vector<Series> _series;
+
+    std::vector<float> _sorted;
+
+    uint64_t _lastFrame = 0;
+
+    size_t _columns  = 120;
+    float  _barWidth = 2.0f;
+
+    uint32_t _textColor  = 0xFFFFFF;
+    uint32_t _graphColor = 0x00FF00;
+};
+
+#endif
@@ -4,8 +4,74 @@
 #include <SDL2/SDL.h>
 
 #include <vector>
+#include <deque>
 #include <string>
 #include <cstring>
+#include <cstdio>
+#include <cctype>
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+#ifdef INSTANT_FONT_ALLOC_CHECK
+#include <cstdlib>
+#include <new>
+#endif
+
+//
+// Define INSTANT_FONT_STATS to collect per-frame rendering statistics
+// (see IF::GetFrameStats()). Without it counters are compiled out.
+//
+#ifdef INSTANT_FONT_STATS
+#define IF_STATS(expr) expr
+#else
+#define IF_STATS(expr)
+#endif
+
+//
+// Define INSTANT_FONT_TRACE to record scoped timings of Init, layout,
+// formatting and submission, which can be dumped as Chrome trace events
+// (see IF::StartTrace() / IF::DumpTrace()).
+//
+#ifdef INSTANT_FONT_TRACE
+#define IF_TRACE_SCOPE(name) IF::TraceScope ifTraceScope(name)
+#else
+#define IF_TRACE_SCOPE(name)
+#endif
+
+//
+// Define INSTANT_FONT_ALLOC_CHECK to count heap allocations made inside
+// IF calls (see IF::ExpectNoAllocations()). Counting needs replaced
+// global operator new: put INSTANT_FONT_ALLOC_HOOK into one source file
+// of the program.
+//
+#ifdef INSTANT_FONT_ALLOC_CHECK
+#define IF_ALLOC_SCOPE() IF::AllocScope ifAllocScope
+
+#define INSTANT_FONT_ALLOC_HOOK                                    \
+  void* operator new(std::size_t size)                            \
+  {                                                                \
+    IF::NoteAllocation();                                          \
+    void* p = std::malloc(size ? size : 1);                        \
+    if (p == nullptr)                                              \
+    {                                                              \
+      throw std::bad_alloc();                                      \
+    }                                                              \
+    return p;                                                      \
+  }                                                                \
+  void operator delete(void* p) noexcept { std::free(p); }         \
+  void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+#else
+#define IF_ALLOC_SCOPE()
+#endif
 
 //
 // IF for "Instant Font"
@@ -20,6 +86,15 @@ class IF
     ~IF()
     {
       SDL_DestroyTexture(_fontAtlas);
+
+      PostBuffer* buffer = _postBuffers.load();
+
+      while (buffer != nullptr)
+      {
+        PostBuffer* next = buffer->Next;
+        delete buffer;
+        buffer = next;
+      }
     }
 
     // -----------------------------------------------------------------------
@@ -32,320 +107,4935 @@ class IF
 
     // -----------------------------------------------------------------------
 
-    bool Init(SDL_Renderer* renderer)
+    using GlyphData = std::vector<std::vector<uint16_t>>;
+
+    //
+    // Bitmap font description.
+    //
+    // Every glyph is stored as GlyphHeight rows of RowWords 16-bit words,
+    // least significant bit being the leftmost pixel. Glyphs up to 16 pixels
+    // wide take exactly one word per row (same as the built-in font),
+    // wider rows are bit-packed across several consecutive words.
+    //
+    struct Font
     {
-      if (_initialized)
-      {
-        SDL_Log("Font manager already initialized!");
-        return true;
-      }
+      uint16_t GlyphWidth  = 0;
+      uint16_t GlyphHeight = 0;
+      uint16_t RowWords    = 0;
 
-      _atlasWidth  = _numTilesH * _fontSize;
-      _atlasHeight = _numTilesV * _fontSize;
+      GlyphData Glyphs;
 
-      _rendererRef = renderer;
-      _fontAtlas = SDL_CreateTexture(_rendererRef,
-                                SDL_PIXELFORMAT_RGBA32,
-                                SDL_TEXTUREACCESS_STREAMING,
-                                _atlasWidth, _atlasHeight);
-      if (_fontAtlas == nullptr)
-      {
-        SDL_Log("%s", SDL_GetError());
-        return false;
-      }
+      //
+      // Codepoint -> index in Glyphs.
+      //
+      std::unordered_map<uint32_t, uint32_t> Codepoints;
 
-      uint8_t* bytes = nullptr;
-      int pitch = 0;
-      int res = SDL_LockTexture(_fontAtlas, nullptr, (void**)(&bytes), &pitch);
-      if (res < 0)
-      {
-        SDL_Log("%s", SDL_GetError());
-        return false;
-      }
+      //
+      // Glyph to use for characters not present in Codepoints.
+      //
+      uint32_t Fallback = 0;
+
+      //
+      // Per-glyph horizontal advance in pixels.
+      // Empty for monospace fonts, otherwise same size as Glyphs.
+      //
+      std::vector<uint16_t> Advances;
+
+      //
+      // Position of the glyph cell relative to the pen for proportional fonts.
+      //
+      int16_t OriginX = 0;
+
+      // -----------------------------------------------------------------------
 
-      auto PutPixel = [this, bytes](size_t x,
-                                    size_t y,
-                                    const uint8_t (&pixel)[4])
+      void Reset(uint16_t glyphWidth, uint16_t glyphHeight)
       {
-        std::memcpy(&bytes[ (x * _atlasWidth + y) * sizeof(pixel) ],
-                    pixel,
-                    sizeof(pixel));
-      };
+        GlyphWidth  = glyphWidth;
+        GlyphHeight = glyphHeight;
+        RowWords    = (glyphWidth + 15) / 16;
+
+        Glyphs.clear();
+        Codepoints.clear();
+        Advances.clear();
 
-      size_t charsDefined = _charMap.size();
+        Fallback = 0;
+        OriginX  = 0;
+      }
 
-      size_t charInd = 0;
+      // -----------------------------------------------------------------------
 
-      for (size_t x = 0; x < _atlasHeight; x += _fontSize)
+      //
+      // Turns monospace font into proportional one: every glyph is shifted
+      // to the left edge of its cell and gets advance equal to its
+      // trimmed width plus spacing. Empty glyphs (like space) get half a cell.
+      //
+      void MakeProportional(uint16_t spacing = 1)
       {
-        size_t xx = x;
+        Advances.assign(Glyphs.size(), GlyphWidth / 2);
 
-        for (size_t y = 0; y < _atlasWidth; y += _fontSize)
+        for (uint32_t glyph = 0; glyph < Glyphs.size(); glyph++)
         {
-          if (charInd < charsDefined)
+          size_t left  = GlyphWidth;
+          size_t right = 0;
+
+          for (size_t y = 0; y < GlyphHeight; y++)
+          {
+            for (size_t x = 0; x < GlyphWidth; x++)
+            {
+              if (Pixel(glyph, x, y))
+              {
+                left  = std::min(left, x);
+                right = std::max(right, x);
+              }
+            }
+          }
+
+          if (left > right)
           {
-            size_t yy = y;
+            continue;
+          }
 
-            const auto& glyph = _charMap[charInd];
+          std::vector<uint16_t> trimmed(Glyphs[glyph].size(), 0);
 
-            for (const auto& line : glyph)
+          for (size_t y = 0; y < GlyphHeight; y++)
+          {
+            for (size_t x = left; x <= right; x++)
             {
-              uint16_t toModify = line;
-              for (size_t i = 0; i < _fontSize; i++)
+              if (Pixel(glyph, x, y))
               {
-                bool isOne = (toModify & 0x1);
-                PutPixel(xx, yy, isOne ? kColorWhite : kColorBlack);
-                toModify >>= 1;
-                yy++;
+                size_t xx = x - left;
+                trimmed[y * RowWords + (xx / 16)] |= (1 << (xx % 16));
               }
-
-              yy = y;
-              xx++;
             }
-
-            xx = x;
           }
 
-          charInd++;
+          Glyphs[glyph] = std::move(trimmed);
+
+          Advances[glyph] = (right - left + 1) + spacing;
         }
+
+        OriginX = 0;
       }
 
-      SDL_UnlockTexture(_fontAtlas);
+      // -----------------------------------------------------------------------
 
+      uint32_t AddGlyph()
+      {
+        Glyphs.emplace_back(GlyphHeight * RowWords, 0);
+        return Glyphs.size() - 1;
+      }
 
-      res = SDL_SetTextureBlendMode(_fontAtlas, SDL_BLENDMODE_BLEND);
-      if (res < 0)
+      // -----------------------------------------------------------------------
+
+      bool Pixel(uint32_t glyph, size_t x, size_t y) const
       {
-        SDL_Log("%s", SDL_GetError());
-        return false;
+        uint16_t word = Glyphs[glyph][y * RowWords + (x / 16)];
+        return (word >> (x % 16)) & 0x1;
       }
 
-      _initialized = true;
+      // -----------------------------------------------------------------------
 
-      return true;
-    }
+      void SetPixel(uint32_t glyph, size_t x, size_t y)
+      {
+        Glyphs[glyph][y * RowWords + (x / 16)] |= (1 << (x % 16));
+      }
+
+      // -----------------------------------------------------------------------
+
+      //
+      // Appends a "box with a cross" glyph (like the last one of the
+      // built-in font) and makes it the fallback one.
+      //
+      void AddFallbackGlyph()
+      {
+        Fallback = AddGlyph();
+
+        size_t w = GlyphWidth  - 1;
+        size_t h = GlyphHeight - 1;
+
+        for (size_t y = 0; y <= h; y++)
+        {
+          size_t diag = (h == 0) ? 0 : (y * w + h / 2) / h;
+
+          SetPixel(Fallback, 0, y);
+          SetPixel(Fallback, w, y);
+          SetPixel(Fallback, diag, y);
+          SetPixel(Fallback, w - diag, y);
+        }
+
+        for (size_t x = 0; x <= w; x++)
+        {
+          SetPixel(Fallback, x, 0);
+          SetPixel(Fallback, x, h);
+        }
+      }
+    };
 
     // -------------------------------------------------------------------------
 
-    enum class TextAlignment
+    //
+    // Initialize with the built-in 9x9 font.
+    //
+    bool Init(SDL_Renderer* renderer)
     {
-      LEFT = 0,
-      CENTER,
-      RIGHT
-    };
+      return Init(renderer, BuiltinFont());
+    }
 
     // -------------------------------------------------------------------------
 
-    struct TextParams
+    //
+    // Built-in 9x9 font, e.g. to call MakeProportional() on it before Init.
+    //
+    Font BuiltinFont() const
     {
-      TextAlignment Align = TextAlignment::LEFT;
-      uint32_t      Color = 0xFFFFFF;
-      double        Scale = 1.0;
+      Font builtin;
 
-      static TextParams Set(uint32_t color = 0xFFFFFF,
-                            TextAlignment align = TextAlignment::LEFT,
-                            double scale = 1.0)
+      builtin.GlyphWidth  = 9;
+      builtin.GlyphHeight = 9;
+      builtin.RowWords    = 1;
+      builtin.Glyphs      = _charMap;
+
+      //
+      // Printable ASCII starting from space, last glyph is the fallback box.
+      //
+      for (uint32_t i = 0; i < _charMap.size() - 1; i++)
       {
-        static TextParams params;
-        params.Color = color;
-        params.Align = align;
-        params.Scale = scale;
-        return params;
+        builtin.Codepoints[i + 32] = i;
       }
-    };
+
+      builtin.Fallback = _charMap.size() - 1;
+
+      return builtin;
+    }
 
     // -------------------------------------------------------------------------
 
-    void Print(int x, int y,
-               const std::string& text,
-               uint32_t color = 0xFFFFFF,
-               TextAlignment align = TextAlignment::LEFT,
-               double scaleFactor = 1.0)
+    bool Init(SDL_Renderer* renderer, const Font& font)
     {
-      if (not _initialized)
-      {
-        SDL_Log("Font manager is not initialized!");
-        return;
-      }
+      return Init(renderer, std::vector<Font> { font });
+    }
 
-      SaveColor();
+    // -------------------------------------------------------------------------
+
+    //
+    // Several fonts share one atlas texture, so switching between them
+    // doesn't break the batch. Font id is the index in the vector.
+    // Glyph missing from a font is looked up in other fonts, by default
+    // in the order they are given (see SetFallbackChain()).
+    //
+    bool Init(SDL_Renderer* renderer, const std::vector<Font>& userFonts)
+    {
+      IF_TRACE_SCOPE("IF::Init");
 
-      const auto& clr = HTML2RGB(color);
+      if (_initialized)
+      {
+        SDL_Log("Font manager already initialized!");
+        return true;
+      }
 
-      SDL_SetTextureColorMod(_fontAtlas, clr.r, clr.g, clr.b);
+      if (userFonts.empty())
+      {
+        SDL_Log("No fonts given!");
+        return false;
+      }
 
-      size_t ln = text.length();
+      for (const Font& font : userFonts)
+      {
+        if (not ValidateFont(font))
+        {
+          return false;
+        }
+      }
 
-      int xOffset = 0;
+      //
+      // Text isn't decoded as UTF-8, so only glyphs of byte values and
+      // the fallback can ever be printed (see README), the rest of a big
+      // font would just take atlas space. Every font gets block glyphs
+      // for bar graphs after its own ones.
+      //
+      std::vector<Font> fonts;
+      fonts.reserve(userFonts.size());
 
-      switch (align)
+      for (const Font& font : userFonts)
       {
-        // --------------------------
-        case TextAlignment::LEFT:
-          xOffset = 0;
-          break;
-        // --------------------------
-        case TextAlignment::RIGHT:
-          xOffset = -ln;
-          break;
-        // --------------------------
-        case TextAlignment::CENTER:
-          xOffset = -(ln / 2);
-          break;
-        // --------------------------
-        default:
-          break;
-        // --------------------------
+        fonts.push_back(ReachableGlyphs(font));
+        AddBlockGlyphs(fonts.back());
       }
 
-      for (char c : text)
+      _fonts.clear();
+      _fonts.resize(fonts.size());
+
+      for (size_t i = 0; i < fonts.size(); i++)
       {
-        size_t charInd = c - 32;
+        SetupFont(_fonts[i], fonts[i]);
 
-        if (c < 32 or c > 127)
+        for (size_t other = 0; other < fonts.size(); other++)
         {
-          charInd = _charMap.size() - 1;
+          if (other != i)
+          {
+            _fonts[i].Chain.push_back(other);
+          }
         }
+      }
+
+      if (not PackRegions(renderer))
+      {
+        return false;
+      }
 
-        size_t xx = (charInd % _numTilesH);
-        size_t yy = (charInd / _numTilesH);
+      for (size_t i = 0; i < _fonts.size(); i++)
+      {
+        BuildGlyphTable(i);
+      }
 
-        static SDL_Rect fromAtlas;
+      _font = &_fonts[0];
 
-        fromAtlas.x = xx * _fontSize;
-        fromAtlas.y = yy * _fontSize;
+      _rendererRef = renderer;
+      _useGeometry = true;
 
-        fromAtlas.w = _fontSize;
-        fromAtlas.h = _fontSize;
+      //
+      // Coverage of the atlas is kept for RestoreAtlas().
+      // Last row of tiles may be partially filled
+      // and regions don't necessarily cover the whole atlas.
+      //
+      _atlasCoverage.assign((size_t)_atlasWidth * _atlasHeight, kCoverNone);
 
-        int scaled = (int)( (double)(xOffset * _fontSize) * scaleFactor );
+      Bitmap base;
+      Bitmap fill;
+      Bitmap edge;
 
-        static SDL_Rect dst;
-        dst.x = x + scaled;
-        dst.y = y;
-        dst.w = (int)( (double)_fontSize * scaleFactor );
-        dst.h = (int)( (double)_fontSize * scaleFactor );
+      for (size_t i = 0; i < fonts.size(); i++)
+      {
+        const Font& font = fonts[i];
 
-        SDL_RenderCopy(_rendererRef, _fontAtlas, &fromAtlas, &dst);
+        for (uint32_t charInd = 0; charInd < font.Glyphs.size(); charInd++)
+        {
+          DrawTiles(_fonts[i],
+                    charInd,
+                    font.Glyphs[charInd].data(),
+                    base, fill, edge);
+        }
+      }
 
-        x += (int)( (double)_fontSize * scaleFactor );
+      if (not UploadAtlas())
+      {
+        return false;
       }
 
-      RestoreColor();
+      ClearLayoutCache();
+
+      _initialized = true;
+
+      return true;
     }
 
     // -------------------------------------------------------------------------
 
-    template <typename ... Args>
-    void Printf(int x, int y,
-                TextParams params,
-                const std::string& formatString,
-                Args ... args)
+    //
+    // Recreates atlas texture from coverage kept since Init, after the
+    // renderer lost its textures. Pass the new renderer if it was
+    // recreated (the old one must be destroyed, its textures went
+    // with it). Everything else, including batched text, stays valid,
+    // so text is back in the same frame.
+    //
+    bool RestoreAtlas(SDL_Renderer* renderer = nullptr)
     {
+      IF_TRACE_SCOPE("IF::RestoreAtlas");
+
       if (not _initialized)
       {
         SDL_Log("Font manager is not initialized!");
-        return;
+        return false;
       }
 
-      size_t size = ::snprintf(nullptr,
-                               0,
-                               formatString.data(),
-                               args ...);
-      if (size == 0)
+      if (renderer == nullptr or renderer == _rendererRef)
       {
-        return;
+        SDL_DestroyTexture(_fontAtlas);
+      }
+      else
+      {
+        //
+        // New renderer gets its own chance at SDL_RenderGeometry.
+        //
+        _rendererRef = renderer;
+        _useGeometry = true;
       }
 
-      static std::string s;
-      s.resize(size);
+      _fontAtlas = nullptr;
 
-      char* buf = (char*)s.data();
-      ::snprintf(buf, size + 1, formatString.data(), args ...);
+      //
+      // New renderer may have a lower texture size limit than the one
+      // the atlas was packed for in Init.
+      //
+      if (not AtlasFits(_rendererRef, _atlasWidth, _atlasHeight))
+      {
+        return false;
+      }
 
-      Print(x, y, s, params.Color, params.Align, params.Scale);
+      return UploadAtlas();
     }
 
     // -------------------------------------------------------------------------
 
     //
-    // Draw the whole bitmap font atlas to the screen.
-    // Used for debugging purposes during development.
+    // Calls RestoreAtlas() on SDL_RENDER_DEVICE_RESET and
+    // SDL_RENDER_TARGETS_RESET (some backends drop texture contents
+    // with the targets). Meant to be called with every event.
+    // Returns false only if restoring failed.
     //
-    void ShowFontBitmap()
+    bool HandleRenderEvent(const SDL_Event& event)
     {
-      static SDL_Rect dst;
-
-      dst.x = 0;
-      dst.y = 0;
-      dst.w = _atlasWidth * 5;
-      dst.h = _atlasHeight * 5;
+      if (event.type == SDL_RENDER_DEVICE_RESET
+       or event.type == SDL_RENDER_TARGETS_RESET)
+      {
+        return RestoreAtlas();
+      }
 
-      SDL_RenderCopy(_rendererRef, _fontAtlas, nullptr, &dst);
+      return true;
     }
 
     // -------------------------------------------------------------------------
 
-  private:
-    IF() = default;
-
-    // -------------------------------------------------------------------------
-
-    const SDL_Color& HTML2RGB(const uint32_t& colorMask)
+    //
+    // Number of empty tiles every font gets in the atlas for glyphs
+    // added by SetGlyph(), on top of what's left in the last row.
+    // Takes effect on Init.
+    //
+    void SetSpareGlyphs(size_t count)
     {
-      _drawColor.r = (colorMask & _maskR) >> 16;
-      _drawColor.g = (colorMask & _maskG) >> 8;
-      _drawColor.b = (colorMask & _maskB);
-      _drawColor.a = 0xFF;
-
-      return _drawColor;
+      _spareGlyphs = count;
     }
 
     // -------------------------------------------------------------------------
 
-    void SaveColor()
+    //
+    // Gives a character (byte value) of the font a new glyph: rows are
+    // laid out as in Font::Glyphs. Glyph that belongs to this character
+    // only is redrawn in place, otherwise (no glyph, fallback, shared)
+    // a spare tile is taken. Characters nobody prints, like control
+    // ones, can hold monochrome HUD icons drawn inline with text.
+    //
+    // Only tiles of the glyph are rendered and uploaded. Advance is
+    // used by proportional fonts, 0 means full cell. Layout cache is
+    // cleared, widgets that keep glyph coordinates need Rebuild().
+    //
+    bool SetGlyph(uint32_t codepoint,
+                  const std::vector<uint16_t>& rows,
+                  size_t fontId = 0,
+                  uint16_t advance = 0)
     {
-      SDL_GetTextureColorMod(_fontAtlas,
-                             &_oldColor.r,
-                             &_oldColor.g,
-                             &_oldColor.b);
-    }
+      IF_TRACE_SCOPE("IF::SetGlyph");
 
-    // -------------------------------------------------------------------------
+      if (not _initialized)
+      {
+        SDL_Log("Font manager is not initialized!");
+        return false;
+      }
 
-    void RestoreColor()
-    {
-      SDL_SetTextureColorMod(_fontAtlas,
-                             _oldColor.r,
-                             _oldColor.g,
-                             _oldColor.b);
-    }
+      if (fontId >= _fonts.size())
+      {
+        SDL_Log("Invalid font id %zu!", fontId);
+        return false;
+      }
 
-    const uint32_t _maskR = 0x00FF0000;
-    const uint32_t _maskG = 0x0000FF00;
-    const uint32_t _maskB = 0x000000FF;
-    const uint32_t _maskA = 0xFF000000;
+      if (codepoint > 255)
+      {
+        SDL_Log("Codepoint %u is out of range!", codepoint);
+        return false;
+      }
 
-    SDL_Color _drawColor;
-    SDL_Color _oldColor;
+      FontSlot& slot = _fonts[fontId];
 
-    bool _initialized = false;
+      size_t rowWords = (slot.GlyphWidth + 15) / 16;
 
-    const uint8_t kColorWhite[4] = { 255, 255, 255, 255 };
-    const uint8_t kColorBlack[4] = {   0,   0,   0,   0 };
+      if (rows.size() != slot.GlyphHeight * rowWords)
+      {
+        SDL_Log("Invalid glyph data!");
+        return false;
+      }
 
-    const uint8_t _numTilesH = 16;
-    const uint8_t _numTilesV = 6;
+      int32_t charInd = slot.Own[codepoint];
 
-    const uint8_t _fontSize = 9;
+      bool shared = (charInd == (int32_t)slot.Fallback);
 
-    uint16_t _atlasWidth  = 0;
-    uint16_t _atlasHeight = 0;
+      for (uint32_t c = 0; c < 256 and not shared; c++)
+      {
+        shared = (c != codepoint and slot.Own[c] == charInd);
+      }
+
+      if (charInd < 0 or shared)
+      {
+        if (slot.NumGlyphs == slot.NumTiles)
+        {
+          SDL_Log("No spare glyph tiles left!");
+          return false;
+        }
+
+        charInd = slot.NumGlyphs++;
+
+        slot.Empty.resize(slot.NumGlyphs);
+
+        if (slot.Proportional)
+        {
+          slot.Advances.resize(slot.NumGlyphs);
+        }
+
+        slot.Own[codepoint] = charInd;
+      }
+
+      auto Blank = [](uint16_t word) { return word == 0; };
+
+      slot.Empty[charInd] = std::all_of(rows.begin(), rows.end(), Blank);
+
+      if (slot.Proportional)
+      {
+        slot.Advances[charInd] = advance ? advance : slot.GlyphWidth;
+      }
+
+      Bitmap base;
+      Bitmap fill;
+      Bitmap edge;
+
+      DrawTiles(slot, charInd, rows.data(), base, fill, edge);
+
+      for (const Variant& variant : slot.Variants)
+      {
+        if (not UploadTile(TileRect(variant, charInd)))
+        {
+          return false;
+        }
+      }
+
+      //
+      // Other fonts may fall back to this glyph.
+      //
+      for (size_t i = 0; i < _fonts.size(); i++)
+      {
+        BuildGlyphTable(i);
+      }
+
+      ClearLayoutCache();
+
+      return true;
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Fonts to look in, in order, when given font doesn't have a glyph.
+    // If none of them has it either, font's own fallback glyph is used.
+    //
+    bool SetFallbackChain(size_t fontId, const std::vector<size_t>& chain)
+    {
+      if (fontId >= _fonts.size())
+      {
+        SDL_Log("Invalid font id %zu!", fontId);
+        return false;
+      }
+
+      for (size_t other : chain)
+      {
+        if (other >= _fonts.size())
+        {
+          SDL_Log("Invalid font id %zu in fallback chain!", other);
+          return false;
+        }
+      }
+
+      _fonts[fontId].Chain = chain;
+
+      BuildGlyphTable(fontId);
+
+      ClearLayoutCache();
+
+      return true;
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Font used by subsequent Print calls.
+    //
+    bool SelectFont(size_t fontId)
+    {
+      if (fontId >= _fonts.size())
+      {
+        SDL_Log("Invalid font id %zu!", fontId);
+        return false;
+      }
+
+      _font = &_fonts[fontId];
+
+      return true;
+    }
+
+    // -------------------------------------------------------------------------
+
+    size_t SelectedFont() const
+    {
+      return _font ? _font - _fonts.data() : 0;
+    }
+
+    // -------------------------------------------------------------------------
+
+    size_t FontCount() const
+    {
+      return _fonts.size();
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Load PC Screen Font version 2 (Linux console fonts, *.psf / *.psfu).
+    // If font has unicode table, glyphs are mapped accordingly,
+    // otherwise glyph index is used as a codepoint.
+    //
+    static bool LoadPSF2(const std::string& fileName, Font& font)
+    {
+      size_t size = 0;
+      uint8_t* data = (uint8_t*)SDL_LoadFile(fileName.data(), &size);
+      if (data == nullptr)
+      {
+        SDL_Log("%s", SDL_GetError());
+        return false;
+      }
+
+      bool ok = ParsePSF2(data, size, font);
+
+      SDL_free(data);
+
+      return ok;
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Load Glyph Bitmap Distribution Format font.
+    // Glyph cell is taken from FONTBOUNDINGBOX, every glyph is placed
+    // inside it according to its BBX relative to the baseline.
+    // DWIDTH becomes glyph advance if it's not the same for all glyphs.
+    //
+    static bool LoadBDF(const std::string& fileName, Font& font)
+    {
+      size_t size = 0;
+      char* data = (char*)SDL_LoadFile(fileName.data(), &size);
+      if (data == nullptr)
+      {
+        SDL_Log("%s", SDL_GetError());
+        return false;
+      }
+
+      std::string text(data, size);
+
+      SDL_free(data);
+
+      return ParseBDF(text, font);
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Load font from BMP image which is a grid of glyphWidth x glyphHeight
+    // cells going left to right, top to bottom, starting from firstCodepoint.
+    // Pixel is considered set if it's bright and opaque.
+    //
+    static bool LoadBMP(const std::string& fileName,
+                        uint16_t glyphWidth,
+                        uint16_t glyphHeight,
+                        Font& font,
+                        uint32_t firstCodepoint = 32)
+    {
+      if (glyphWidth == 0 or glyphHeight == 0)
+      {
+        SDL_Log("Invalid glyph size!");
+        return false;
+      }
+
+      SDL_Surface* bmp = SDL_LoadBMP(fileName.data());
+      if (bmp == nullptr)
+      {
+        SDL_Log("%s", SDL_GetError());
+        return false;
+      }
+
+      SDL_Surface* sheet = SDL_ConvertSurfaceFormat(bmp,
+                                                    SDL_PIXELFORMAT_RGBA32,
+                                                    0);
+      SDL_FreeSurface(bmp);
+
+      if (sheet == nullptr)
+      {
+        SDL_Log("%s", SDL_GetError());
+        return false;
+      }
+
+      int cols = sheet->w / glyphWidth;
+      int rows = sheet->h / glyphHeight;
+
+      if (cols == 0 or rows == 0 or SDL_LockSurface(sheet) < 0)
+      {
+        SDL_Log("Can't read glyphs from %s", fileName.data());
+        SDL_FreeSurface(sheet);
+        return false;
+      }
+
+      font.Reset(glyphWidth, glyphHeight);
+
+      const uint8_t* pixels = (const uint8_t*)sheet->pixels;
+
+      for (int ty = 0; ty < rows; ty++)
+      {
+        for (int tx = 0; tx < cols; tx++)
+        {
+          uint32_t glyph = font.AddGlyph();
+          font.Codepoints[firstCodepoint + glyph] = glyph;
+
+          for (size_t y = 0; y < glyphHeight; y++)
+          {
+            const uint8_t* line = pixels
+                                + (ty * glyphHeight + y) * sheet->pitch
+                                + (tx * glyphWidth) * 4;
+
+            for (size_t x = 0; x < glyphWidth; x++)
+            {
+              const uint8_t* px = &line[x * 4];
+
+              int brightness = px[0] + px[1] + px[2];
+              if (px[3] >= 128 and brightness >= 384)
+              {
+                font.SetPixel(glyph, x, y);
+              }
+            }
+          }
+        }
+      }
+
+      SDL_UnlockSurface(sheet);
+      SDL_FreeSurface(sheet);
+
+      font.AddFallbackGlyph();
+
+      return true;
+    }
+
+    // -------------------------------------------------------------------------
+
+    enum class TextAlignment
+    {
+      LEFT = 0,
+      CENTER,
+      RIGHT
+    };
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Outline and shadow are pre-baked into the atlas in black,
+    // so effect text costs the same single quad per glyph as plain one.
+    //
+    enum class TextEffect
+    {
+      NONE = 0,
+      OUTLINE,
+      SHADOW
+    };
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Bold is glyph ORed with itself moved one pixel right,
+    // italic shears rows to the right towards the top of the cell.
+    // Both are generated into the atlas, pen advance stays the same.
+    //
+    enum class TextStyle
+    {
+      REGULAR = 0,
+      BOLD,
+      ITALIC,
+      BOLD_ITALIC
+    };
+
+    // -------------------------------------------------------------------------
+
+    struct TextParams
+    {
+      TextAlignment Align  = TextAlignment::LEFT;
+      uint32_t      Color  = 0xFFFFFF;
+      double        Scale  = 1.0;
+      TextEffect    Effect = TextEffect::NONE;
+      TextStyle     Style  = TextStyle::REGULAR;
+
+      static TextParams Set(uint32_t color = 0xFFFFFF,
+                            TextAlignment align = TextAlignment::LEFT,
+                            double scale = 1.0,
+                            TextEffect effect = TextEffect::NONE,
+                            TextStyle style = TextStyle::REGULAR)
+      {
+        TextParams params;
+        params.Color  = color;
+        params.Align  = align;
+        params.Scale  = scale;
+        params.Effect = effect;
+        params.Style  = style;
+        return params;
+      }
+    };
+
+    // -------------------------------------------------------------------------
+
+    void Print(int x, int y,
+               const std::string& text,
+               uint32_t color = 0xFFFFFF,
+               TextAlignment align = TextAlignment::LEFT,
+               double scaleFactor = 1.0,
+               TextEffect effect = TextEffect::NONE,
+               TextStyle style = TextStyle::REGULAR)
+    {
+      PrintText(x, y,
+                text.data(), text.length(),
+                color, align, scaleFactor, effect, style, false);
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Same for C strings, so that literals don't make a temporary string.
+    //
+    void Print(int x, int y,
+               const char* text,
+               uint32_t color = 0xFFFFFF,
+               TextAlignment align = TextAlignment::LEFT,
+               double scaleFactor = 1.0,
+               TextEffect effect = TextEffect::NONE,
+               TextStyle style = TextStyle::REGULAR)
+    {
+      PrintText(x, y,
+                text, std::strlen(text),
+                color, align, scaleFactor, effect, style, false);
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Prints text with inline tags that change appearance of what follows:
+    //
+    //   {#RRGGBB}   color (keeps current alpha)
+    //   {#AARRGGBB} color with alpha
+    //   {b} {i}     bold, italic (combine into bold italic)
+    //   {r}         regular style
+    //   {o} {s}     outline, shadow
+    //   {n}         no effect
+    //   {f0}..{f9}  font
+    //   {/}         back to color, effect, style and font of the call
+    //   {{          literal '{'
+    //
+    // Anything else in braces is printed as is. Tags take no space,
+    // alignment applies to the visible text, and all runs go
+    // into a single submission.
+    //
+    void PrintMarkup(int x, int y,
+                     const std::string& text,
+                     uint32_t color = 0xFFFFFF,
+                     TextAlignment align = TextAlignment::LEFT,
+                     double scaleFactor = 1.0,
+                     TextEffect effect = TextEffect::NONE,
+                     TextStyle style = TextStyle::REGULAR)
+    {
+      PrintText(x, y,
+                text.data(), text.length(),
+                color, align, scaleFactor, effect, style, true);
+    }
+
+    // -------------------------------------------------------------------------
+
+    void PrintMarkup(int x, int y,
+                     const char* text,
+                     uint32_t color = 0xFFFFFF,
+                     TextAlignment align = TextAlignment::LEFT,
+                     double scaleFactor = 1.0,
+                     TextEffect effect = TextEffect::NONE,
+                     TextStyle style = TextStyle::REGULAR)
+    {
+      PrintText(x, y,
+                text, std::strlen(text),
+                color, align, scaleFactor, effect, style, true);
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Everything printed between BeginBatch() and Flush() is submitted
+    // as a single draw call. Outside of a batch every Print is flushed
+    // immediately, so it's drawn in order with other renderer calls.
+    //
+    void BeginBatch()
+    {
+      _batching = true;
+
+#ifdef INSTANT_FONT_TRACE
+      _batchStart = SDL_GetPerformanceCounter();
+#endif
+    }
+
+    // -------------------------------------------------------------------------
+
+    void Flush()
+    {
+      IF_ALLOC_SCOPE();
+
+#ifdef INSTANT_FONT_TRACE
+      if (_batching)
+      {
+        AddTraceEvent("IF::Batch", _batchStart, SDL_GetPerformanceCounter());
+      }
+#endif
+
+      _batching = false;
+
+      if (_postBuffers.load(std::memory_order_acquire) != nullptr)
+      {
+        LayoutPosted();
+      }
+
+      if (_numVertices != 0)
+      {
+        IF_TRACE_SCOPE("IF::Flush");
+
+        size_t numQuads = _numVertices / 4;
+
+        if (_indices.size() < numQuads * 6)
+        {
+          BuildIndices(_indices, numQuads);
+        }
+
+        Submit(_vertices.data(), _numVertices, _indices.data(), _stats);
+
+        _numVertices = 0;
+      }
+
+      _arena.Reset();
+
+      AgeLayoutCache();
+
+#ifdef INSTANT_FONT_ALLOC_CHECK
+      CheckAllocations("Flush()");
+#endif
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Pipelined frames: one thread records text of the next frame
+    // between BeginFrame() and EndFrame() while the render thread keeps
+    // drawing the previous one with SubmitFrame(). Layout, formatting and
+    // vertex generation all happen on the recording thread.
+    //
+    // SetFrameLists() enables it with given number of command lists
+    // (at least two, more let the recording thread run further ahead)
+    // and should be called while frames are neither recorded nor drawn.
+    // Zero goes back to immediate submission.
+    //
+    // While frames are recorded, Print* belong to the recording thread,
+    // Post* can still be used from anywhere.
+    //
+    bool SetFrameLists(size_t count)
+    {
+      std::lock_guard<std::mutex> lock(_frameMutex);
+
+      if (_recordList != kNoList)
+      {
+        SDL_Log("Can't change frame lists while a frame is recorded!");
+        return false;
+      }
+
+      if (count == 1)
+      {
+        SDL_Log("At least two frame lists are needed!");
+        return false;
+      }
+
+      _frameLists.clear();
+      _frameLists.resize(count);
+
+      _freeLists.clear();
+      _readyLists.clear();
+
+      for (size_t i = 0; i < count; i++)
+      {
+        _freeLists.push_back(i);
+      }
+
+      _shownList = kNoList;
+
+      return true;
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Starts recording the next frame. Waits while all lists are either
+    // shown or ready to be shown, which keeps the recording thread
+    // at most (lists - 1) frames ahead of the render thread.
+    // For the same reason calling it on the render thread without
+    // submitting the frames in between never returns.
+    //
+    void BeginFrame()
+    {
+      IF_ALLOC_SCOPE();
+
+      if (_frameLists.empty())
+      {
+        SDL_Log("Frame lists are not enabled!");
+        return;
+      }
+
+      {
+        std::unique_lock<std::mutex> lock(_frameMutex);
+
+        _frameFree.wait(lock, [this]() { return not _freeLists.empty(); });
+
+        _recordList = _freeLists.back();
+        _freeLists.pop_back();
+      }
+
+      FrameList& list = _frameLists[_recordList];
+
+      AddSubmitStats(list.Stats);
+      list.Stats = FrameStats();
+
+      //
+      // Batch is recorded straight into the list's storage.
+      //
+      std::swap(_vertices, list.Vertices);
+      _numVertices = 0;
+
+      BeginBatch();
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Finishes recording and queues the frame for the render thread.
+    //
+    void EndFrame()
+    {
+      IF_ALLOC_SCOPE();
+
+      if (_recordList == kNoList)
+      {
+        SDL_Log("EndFrame() without BeginFrame()!");
+        return;
+      }
+
+      if (_postBuffers.load(std::memory_order_acquire) != nullptr)
+      {
+        LayoutPosted();
+      }
+
+#ifdef INSTANT_FONT_TRACE
+      AddTraceEvent("IF::Frame", _batchStart, SDL_GetPerformanceCounter());
+#endif
+
+      _batching = false;
+
+      FrameList& list = _frameLists[_recordList];
+
+      std::swap(_vertices, list.Vertices);
+      list.NumVertices = _numVertices;
+      _numVertices = 0;
+
+      size_t numQuads = list.NumVertices / 4;
+
+      if (list.Indices.size() < numQuads * 6)
+      {
+        BuildIndices(list.Indices, numQuads);
+      }
+
+      {
+        std::lock_guard<std::mutex> lock(_frameMutex);
+
+        _readyLists.push_back(_recordList);
+        _recordList = kNoList;
+      }
+
+      _arena.Reset();
+
+      AgeLayoutCache();
+
+#ifdef INSTANT_FONT_ALLOC_CHECK
+      CheckAllocations("EndFrame()");
+#endif
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Render thread: draws the next recorded frame, or the one drawn
+    // last time if there is no newer one. Returns false if nothing
+    // was recorded yet. Submission statistics of a frame are added
+    // to FrameStats when its list is reused for recording. Only the
+    // first submission of a frame is counted, redrawing it is not.
+    //
+    bool SubmitFrame()
+    {
+      IF_ALLOC_SCOPE();
+
+      size_t shown   = kNoList;
+      bool   newList = false;
+
+      {
+        std::lock_guard<std::mutex> lock(_frameMutex);
+
+        if (not _readyLists.empty())
+        {
+          if (_shownList != kNoList)
+          {
+            _freeLists.push_back(_shownList);
+            _frameFree.notify_one();
+          }
+
+          _shownList = _readyLists.front();
+          _readyLists.pop_front();
+
+          newList = true;
+        }
+
+        shown = _shownList;
+      }
+
+      if (shown == kNoList)
+      {
+        return false;
+      }
+
+      IF_TRACE_SCOPE("IF::SubmitFrame");
+
+      FrameList& list = _frameLists[shown];
+
+      FrameStats redrawStats;
+
+      if (list.NumVertices != 0)
+      {
+        Submit(list.Vertices.data(),
+               list.NumVertices,
+               list.Indices.data(),
+               newList ? list.Stats : redrawStats);
+      }
+
+      return true;
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Rendering statistics accumulated since the last ResetFrameStats().
+    // All zeroes unless compiled with INSTANT_FONT_STATS.
+    //
+    struct FrameStats
+    {
+      //
+      // Glyph quads sent to the renderer.
+      //
+      uint64_t GlyphsSubmitted = 0;
+
+      //
+      // Characters that produced no quad (blank glyphs).
+      //
+      uint64_t GlyphsCulled = 0;
+
+      uint64_t DrawCalls           = 0;
+      uint64_t TextureStateChanges = 0;
+
+      //
+      // Output of snprintf in Printf.
+      //
+      uint64_t BytesFormatted = 0;
+
+      //
+      // Text posted from other threads that was drawn and that
+      // didn't fit into the posting thread's buffer.
+      //
+      uint64_t TextPosted   = 0;
+      uint64_t PostsDropped = 0;
+
+      //
+      // Strings found in layout cache and laid out anew.
+      //
+      uint64_t LayoutCacheHits   = 0;
+      uint64_t LayoutCacheMisses = 0;
+
+      //
+      // Performance counter ticks spent building quads and submitting them.
+      //
+      uint64_t LayoutTicks = 0;
+      uint64_t SubmitTicks = 0;
+    };
+
+    // -------------------------------------------------------------------------
+
+    const FrameStats& GetFrameStats() const
+    {
+      return _stats;
+    }
+
+    // -------------------------------------------------------------------------
+
+    void ResetFrameStats()
+    {
+      IF_STATS(_stats = FrameStats());
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Prints current frame statistics. Does nothing without INSTANT_FONT_STATS.
+    // Call before ResetFrameStats(), the overlay itself is counted
+    // in the next frame.
+    //
+    void DrawStatsOverlay(int x, int y, uint32_t color = 0xFFFF00)
+    {
+#ifdef INSTANT_FONT_STATS
+      //
+      // Printing below changes the counters, so work on a copy.
+      //
+      FrameStats stats = _stats;
+
+      double toUs = 1e6 / (double)SDL_GetPerformanceFrequency();
+
+      int lineHeight = GlyphHeight() + 1;
+
+      TextParams params = TextParams::Set(color);
+
+      Printf(x, y + lineHeight * 0, params,
+             "glyphs:  %llu (+%llu culled)",
+             (unsigned long long)stats.GlyphsSubmitted,
+             (unsigned long long)stats.GlyphsCulled);
+      Printf(x, y + lineHeight * 1, params,
+             "draws:   %llu, texture changes: %llu",
+             (unsigned long long)stats.DrawCalls,
+             (unsigned long long)stats.TextureStateChanges);
+      Printf(x, y + lineHeight * 2, params,
+             "printf:  %llu bytes",
+             (unsigned long long)stats.BytesFormatted);
+      Printf(x, y + lineHeight * 3, params,
+             "posted:  %llu (%llu dropped)",
+             (unsigned long long)stats.TextPosted,
+             (unsigned long long)stats.PostsDropped);
+      Printf(x, y + lineHeight * 4, params,
+             "cache:   %llu hits, %llu misses",
+             (unsigned long long)stats.LayoutCacheHits,
+             (unsigned long long)stats.LayoutCacheMisses);
+      Printf(x, y + lineHeight * 5, params,
+             "layout:  %.1f us",
+             (double)stats.LayoutTicks * toUs);
+      Printf(x, y + lineHeight * 6, params,
+             "submit:  %.1f us",
+             (double)stats.SubmitTicks * toUs);
+#endif
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Records a complete trace event from construction to destruction
+    // while tracing is on. Can be used to mark application's own
+    // frame stages to see them on the same timeline.
+    //
+    struct TraceScope
+    {
+      explicit TraceScope(const char* name)
+        : Name(name),
+          Start(SDL_GetPerformanceCounter())
+      {
+      }
+
+      ~TraceScope()
+      {
+        IF::Instance().AddTraceEvent(Name, Start, SDL_GetPerformanceCounter());
+      }
+
+      const char* Name;
+      uint64_t    Start;
+    };
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Starts recording into a buffer of given number of events.
+    // Events beyond capacity are dropped. Requires INSTANT_FONT_TRACE
+    // for internal timings, TraceScope works regardless.
+    //
+    void StartTrace(size_t capacity = 65536)
+    {
+      StopTrace();
+
+      _traceEvents.resize(capacity);
+      _traceCount  = 0;
+      _traceOrigin = SDL_GetPerformanceCounter();
+
+      _tracing = true;
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Returns once events other threads are adding are written,
+    // so the buffer can be dumped or resized.
+    //
+    void StopTrace()
+    {
+      _tracing = false;
+
+      while (_traceWriters.load() != 0)
+      {
+        SDL_Delay(0);
+      }
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Thread safe: slot is claimed with a single atomic increment.
+    // Writers are counted, so StartTrace() doesn't resize the buffer
+    // under them. Name must be a string literal or otherwise outlive
+    // the trace.
+    //
+    void AddTraceEvent(const char* name, uint64_t start, uint64_t end)
+    {
+      if (not _tracing.load(std::memory_order_relaxed))
+      {
+        return;
+      }
+
+      _traceWriters.fetch_add(1);
+
+      //
+      // Checked again after being counted: either StopTrace() sees
+      // this writer or the writer sees tracing stopped.
+      //
+      if (_tracing.load())
+      {
+        size_t slot = _traceCount.fetch_add(1, std::memory_order_relaxed);
+
+        if (slot < _traceEvents.size())
+        {
+          TraceEvent& event = _traceEvents[slot];
+
+          event.Name     = name;
+          event.Start    = start;
+          event.Duration = end - start;
+          event.Thread   = SDL_ThreadID();
+        }
+      }
+
+      _traceWriters.fetch_sub(1);
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Writes recorded events as Chrome trace event JSON
+    // (chrome://tracing, Perfetto). Should be called after StopTrace()
+    // or when no other thread is recording.
+    //
+    bool DumpTrace(const std::string& fileName)
+    {
+      SDL_RWops* file = SDL_RWFromFile(fileName.data(), "w");
+      if (file == nullptr)
+      {
+        SDL_Log("%s", SDL_GetError());
+        return false;
+      }
+
+      size_t count = std::min(_traceCount.load(), _traceEvents.size());
+
+      double toUs = 1e6 / (double)SDL_GetPerformanceFrequency();
+
+      const char* header = "{\"traceEvents\":[\n";
+      SDL_RWwrite(file, header, 1, std::strlen(header));
+
+      char line[256];
+
+      for (size_t i = 0; i < count; i++)
+      {
+        const TraceEvent& event = _traceEvents[i];
+
+        int len = ::snprintf(line, sizeof(line),
+                             "{\"name\":\"%s\",\"cat\":\"instant-font\","
+                             "\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+                             "\"pid\":0,\"tid\":%lu}%s\n",
+                             event.Name,
+                             (double)(event.Start - _traceOrigin) * toUs,
+                             (double)event.Duration * toUs,
+                             event.Thread,
+                             (i + 1 < count) ? "," : "");
+
+        SDL_RWwrite(file, line, 1, std::min((size_t)len, sizeof(line) - 1));
+      }
+
+      const char* footer = "]}\n";
+      SDL_RWwrite(file, footer, 1, std::strlen(footer));
+
+      SDL_RWclose(file);
+
+      return true;
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // With INSTANT_FONT_ALLOC_CHECK defined, once printed text settles
+    // and all internal buffers reached their size, nothing in IF should
+    // allocate. While expected, Flush() and EndFrame() assert that
+    // no heap allocation was counted inside IF since the previous one.
+    // Without the define allocations aren't counted and this does nothing.
+    //
+    void ExpectNoAllocations(bool enabled)
+    {
+      _expectNoAllocations = enabled;
+      _allocationsChecked  = Allocations();
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Heap allocations counted inside IF calls so far, on all threads.
+    //
+    static uint64_t Allocations()
+    {
+      return AllocationCount().load(std::memory_order_relaxed);
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Called from operator new defined by INSTANT_FONT_ALLOC_HOOK.
+    //
+    static void NoteAllocation()
+    {
+      if (AllocScope::Depth() > 0)
+      {
+        AllocationCount().fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Enables AVX2 quad generation for long monospace strings
+    // (if compiled with AVX2 support). On by default,
+    // can be turned off to compare against the scalar loop.
+    //
+    void SetVectorized(bool enabled)
+    {
+      _vectorized = enabled;
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Print and PrintMarkup remember finished layouts of recent strings
+    // (by text, color, scale, alignment, effect, style and font) relative
+    // to their position once printed twice. When the same string
+    // is printed again, its quads are copied and moved instead of laying
+    // it out again.
+    //
+    // Cache holds given number of entries (rounded up to a multiple
+    // of 4), zero turns it off. When full, least recently used ones are
+    // replaced. On by default. Storage of all entries is allocated here,
+    // for strings of up to kCacheMaxLength bytes, so printing never
+    // allocates for the cache. Longer strings are laid out every time.
+    //
+    // Strings that weren't printed for maxAge milliseconds are dropped.
+    // Flush() and EndFrame() check a few entries each, so this needs
+    // no calls of its own.
+    //
+    void SetLayoutCache(size_t entries, uint32_t maxAge = 2000)
+    {
+      size_t sets = 1;
+
+      while (sets * kCacheWays < entries)
+      {
+        sets *= 2;
+      }
+
+      size_t slots = entries ? sets * kCacheWays : 0;
+
+      std::vector<CachedLayout>(slots).swap(_layoutCache);
+      std::vector<uint64_t>(slots).swap(_cacheSeen);
+      std::vector<char>(slots * kCacheMaxLength).swap(_cacheText);
+      std::vector<SDL_Vertex>(slots * kCacheMaxLength * 4)
+        .swap(_cacheQuads);
+
+      _cacheSetMask = sets - 1;
+      _cacheMaxAge  = std::max(maxAge, (uint32_t)1);
+    }
+
+    // -------------------------------------------------------------------------
+
+    bool IsBatching() const
+    {
+      return _batching;
+    }
+
+    // -------------------------------------------------------------------------
+
+    bool IsInitialized() const
+    {
+      return _initialized;
+    }
+
+    // -------------------------------------------------------------------------
+
+    uint16_t GlyphWidth() const
+    {
+      return _font ? _font->GlyphWidth : 0;
+    }
+
+    // -------------------------------------------------------------------------
+
+    uint16_t GlyphHeight() const
+    {
+      return _font ? _font->GlyphHeight : 0;
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Low level output for widgets that do their own layout.
+    // BeginGlyphs() reserves room for up to count glyphs of given color
+    // and style, PutGlyph() writes one of them and EndGlyphs() commits
+    // what was written. x, y is the glyph cell position.
+    //
+    // Before Init() BeginGlyphs() returns nullptr, which the others
+    // take and do nothing.
+    //
+    SDL_Vertex* BeginGlyphs(size_t count,
+                            uint32_t color,
+                            TextStyle style = TextStyle::REGULAR)
+    {
+      IF_ALLOC_SCOPE();
+
+      if (not _initialized)
+      {
+        SDL_Log("Font manager is not initialized!");
+        return nullptr;
+      }
+
+      _vertexColor = HTML2RGB(color);
+      _variant     = &_font->Variants[VariantIndex(style, TextEffect::NONE)];
+
+      return ReserveQuads(count);
+    }
+
+    // -------------------------------------------------------------------------
+
+    SDL_Vertex* PutGlyph(SDL_Vertex* out,
+                         float x, float y,
+                         float scale,
+                         uint8_t c)
+    {
+      if (out == nullptr)
+      {
+        return out;
+      }
+
+      const GlyphInfo& glyph = _variant->Glyphs[c];
+
+      if (glyph.Empty)
+      {
+        return out;
+      }
+
+      return WriteQuad(out,
+                       x + glyph.OffsetX * scale,
+                       y + glyph.OffsetY * scale,
+                       glyph.Source.w * scale,
+                       glyph.Source.h * scale,
+                       glyph.U0, glyph.V0, glyph.U1, glyph.V1);
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Writes quad of a glyph of the selected font into caller's storage,
+    // for widgets that keep their quads between frames. Blank glyphs
+    // are written too, so a slot can later take another glyph. Glyphs
+    // taken from fallback fonts differ in size and offset, so switching
+    // means copying the whole quad, not only texture coordinates.
+    //
+    void GlyphQuad(SDL_Vertex* quad,
+                   float x, float y,
+                   float scale,
+                   uint8_t c,
+                   uint32_t color,
+                   TextStyle style = TextStyle::REGULAR)
+    {
+      if (not _initialized)
+      {
+        SDL_Log("Font manager is not initialized!");
+        return;
+      }
+
+      const GlyphInfo& glyph =
+        _font->Variants[VariantIndex(style, TextEffect::NONE)].Glyphs[c];
+
+      _vertexColor = HTML2RGB(color);
+
+      WriteQuad(quad,
+                x + glyph.OffsetX * scale,
+                y + glyph.OffsetY * scale,
+                glyph.Source.w * scale,
+                glyph.Source.h * scale,
+                glyph.U0, glyph.V0, glyph.U1, glyph.V1);
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Heights of block glyphs generated for every font.
+    //
+    static constexpr int kBlockLevels = 8;
+
+    //
+    // Writes a bar between BeginGlyphs() and EndGlyphs(): block glyph
+    // filling level eighths of the cell from the bottom, stretched
+    // to given width. x, y is the cell position.
+    //
+    SDL_Vertex* PutBlock(SDL_Vertex* out,
+                         float x, float y,
+                         float width,
+                         float scale,
+                         int level)
+    {
+      if (out == nullptr or level <= 0)
+      {
+        return out;
+      }
+
+      const GlyphInfo& glyph = _font->Blocks[std::min(level, kBlockLevels) - 1];
+
+      return WriteQuad(out,
+                       x,
+                       y + glyph.OffsetY * scale,
+                       width,
+                       glyph.Source.h * scale,
+                       glyph.U0, glyph.V0, glyph.U1, glyph.V1);
+    }
+
+    // -------------------------------------------------------------------------
+
+    void EndGlyphs(SDL_Vertex* out)
+    {
+      if (out == nullptr)
+      {
+        return;
+      }
+
+      CommitQuads(out);
+
+      if (not _batching)
+      {
+        Flush();
+      }
+    }
+
+    // -------------------------------------------------------------------------
+
+    template <typename ... Args>
+    void Printf(int x, int y,
+                TextParams params,
+                const std::string& formatString,
+                Args ... args)
+    {
+      Printf(x, y, params, formatString.c_str(), args ...);
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Formats into the arena of the current batch.
+    //
+    template <typename ... Args>
+    void Printf(int x, int y,
+                TextParams params,
+                const char* formatString,
+                Args ... args)
+    {
+      IF_ALLOC_SCOPE();
+
+      if (not _initialized)
+      {
+        SDL_Log("Font manager is not initialized!");
+        return;
+      }
+
+      char* text = nullptr;
+      int   size = 0;
+
+      {
+        IF_TRACE_SCOPE("IF::Format");
+
+        size = ::snprintf(nullptr, 0, formatString, args ...);
+        if (size <= 0)
+        {
+          return;
+        }
+
+        IF_STATS(_stats.BytesFormatted += size);
+
+        text = _arena.Allocate<char>(size + 1);
+        ::snprintf(text, size + 1, formatString, args ...);
+      }
+
+      PrintText(x, y,
+                text, size,
+                params.Color, params.Align, params.Scale,
+                params.Effect, params.Style,
+                false);
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Post, PostMarkup and Postf can be called from any thread after Init.
+    // Text is recorded into a ring buffer of the calling thread without
+    // locks and, after the thread's first call, without allocations.
+    // Render thread draws it at the next Flush() in the order each thread
+    // posted it, with the font selected at that moment. Text that doesn't
+    // fit into the buffer is dropped.
+    //
+    void Post(int x, int y,
+              const std::string& text,
+              uint32_t color = 0xFFFFFF,
+              TextAlignment align = TextAlignment::LEFT,
+              double scaleFactor = 1.0,
+              TextEffect effect = TextEffect::NONE,
+              TextStyle style = TextStyle::REGULAR)
+    {
+      PostText(x, y,
+               text.data(), text.length(),
+               color, align, scaleFactor, effect, style, false);
+    }
+
+    // -------------------------------------------------------------------------
+
+    void Post(int x, int y,
+              const char* text,
+              uint32_t color = 0xFFFFFF,
+              TextAlignment align = TextAlignment::LEFT,
+              double scaleFactor = 1.0,
+              TextEffect effect = TextEffect::NONE,
+              TextStyle style = TextStyle::REGULAR)
+    {
+      PostText(x, y,
+               text, std::strlen(text),
+               color, align, scaleFactor, effect, style, false);
+    }
+
+    // -------------------------------------------------------------------------
+
+    void PostMarkup(int x, int y,
+                    const std::string& text,
+                    uint32_t color = 0xFFFFFF,
+                    TextAlignment align = TextAlignment::LEFT,
+                    double scaleFactor = 1.0,
+                    TextEffect effect = TextEffect::NONE,
+                    TextStyle style = TextStyle::REGULAR)
+    {
+      PostText(x, y,
+               text.data(), text.length(),
+               color, align, scaleFactor, effect, style, true);
+    }
+
+    // -------------------------------------------------------------------------
+
+    void PostMarkup(int x, int y,
+                    const char* text,
+                    uint32_t color = 0xFFFFFF,
+                    TextAlignment align = TextAlignment::LEFT,
+                    double scaleFactor = 1.0,
+                    TextEffect effect = TextEffect::NONE,
+                    TextStyle style = TextStyle::REGULAR)
+    {
+      PostText(x, y,
+               text, std::strlen(text),
+               color, align, scaleFactor, effect, style, true);
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Formats straight into the posting thread's buffer.
+    //
+    template <typename ... Args>
+    void Postf(int x, int y,
+               TextParams params,
+               const std::string& formatString,
+               Args ... args)
+    {
+      Postf(x, y, params, formatString.c_str(), args ...);
+    }
+
+    // -------------------------------------------------------------------------
+
+    template <typename ... Args>
+    void Postf(int x, int y,
+               TextParams params,
+               const char* formatString,
+               Args ... args)
+    {
+      IF_ALLOC_SCOPE();
+      IF_TRACE_SCOPE("IF::Format");
+
+      int size = ::snprintf(nullptr, 0, formatString, args ...);
+      if (size <= 0)
+      {
+        return;
+      }
+
+      PostBuffer* buffer = ThreadPostBuffer();
+
+      PostedText* posted = buffer->Reserve(size);
+      if (posted == nullptr)
+      {
+        return;
+      }
+
+      ::snprintf((char*)(posted + 1), size + 1, formatString, args ...);
+
+      FillPosted(*posted,
+                 x, y, size,
+                 params.Color, params.Align, params.Scale,
+                 params.Effect, params.Style, false);
+
+      buffer->Commit();
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Size of buffers created for threads that haven't posted yet.
+    //
+    void SetPostBufferSize(size_t bytes)
+    {
+      _postBufferSize = bytes;
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Draw the whole bitmap font atlas to the screen.
+    // Used for debugging purposes during development.
+    //
+    void ShowFontBitmap(int scale = 5)
+    {
+      SDL_Rect dst;
+
+      dst.x = 0;
+      dst.y = 0;
+      dst.w = _atlasWidth * scale;
+      dst.h = _atlasHeight * scale;
+
+      SDL_RenderCopy(_rendererRef, _fontAtlas, nullptr, &dst);
+    }
+
+    // -------------------------------------------------------------------------
+
+  private:
+    IF() = default;
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Everything Print needs to know about a character.
+    //
+    struct GlyphInfo
+    {
+      uint32_t Index = 0;
+      SDL_Rect Source;
+
+      float U0 = 0.0f;
+      float V0 = 0.0f;
+      float U1 = 0.0f;
+      float V1 = 0.0f;
+
+      //
+      // Quad position relative to the pen, size is that of Source.
+      //
+      int16_t OffsetX = 0;
+      int16_t OffsetY = 0;
+
+      uint16_t Advance = 0;
+      bool     Empty   = true;
+    };
+
+    // -------------------------------------------------------------------------
+
+    static constexpr size_t kNumStyles   = 4;
+    static constexpr size_t kNumEffects  = 3;
+    static constexpr size_t kNumVariants = kNumStyles * kNumEffects;
+
+    //
+    // Every variant is a separate region of the atlas with glyphs
+    // of the font in the same order, but of its own cell size.
+    // Glyph table may point into regions of other fonts.
+    //
+    struct Variant
+    {
+      TextStyle  Style  = TextStyle::REGULAR;
+      TextEffect Effect = TextEffect::NONE;
+
+      int Width  = 0;
+      int Height = 0;
+
+      //
+      // Quad position relative to the glyph cell.
+      //
+      int OffsetX = 0;
+      int OffsetY = 0;
+
+      int AtlasX = 0;
+      int AtlasY = 0;
+
+      GlyphInfo Glyphs[256];
+
+      //
+      // Structure-of-arrays copy of the glyph table for vector gathers.
+      //
+      alignas(32) float   U0[256];
+      alignas(32) float   V0[256];
+      alignas(32) float   U1[256];
+      alignas(32) float   V1[256];
+      alignas(32) int32_t Visible[256];
+    };
+
+    // -------------------------------------------------------------------------
+
+    //
+    // One of the fonts sharing the atlas.
+    //
+    struct FontSlot
+    {
+      uint16_t GlyphWidth  = 0;
+      uint16_t GlyphHeight = 0;
+      int16_t  OriginX     = 0;
+
+      bool Proportional = false;
+
+      //
+      // Some glyphs come from other fonts of the chain. Text that
+      // has any of them is laid out glyph by glyph instead of
+      // on a fixed grid.
+      //
+      bool Mixed = false;
+      bool Foreign[256];
+
+      size_t   NumGlyphs = 0;
+      uint32_t Fallback  = 0;
+
+      //
+      // Tiles of every region, those after NumGlyphs are spare.
+      //
+      size_t NumTiles = 0;
+
+      //
+      // Index of the first block glyph, they are the last ones.
+      //
+      uint32_t  BlockBase = 0;
+      GlyphInfo Blocks[kBlockLevels];
+
+      //
+      // Glyph index for every byte value, -1 if font doesn't have it.
+      //
+      int32_t Own[256];
+
+      std::vector<uint16_t> Advances;
+      std::vector<uint8_t>  Empty;
+
+      std::vector<size_t> Chain;
+
+      Variant Variants[kNumVariants];
+    };
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Scratch bitmap for building variants, rows are laid out
+    // the same way as in Font::Glyphs.
+    //
+    struct Bitmap
+    {
+      int Width    = 0;
+      int Height   = 0;
+      int RowWords = 0;
+
+      std::vector<uint16_t> Bits;
+
+      void Reset(int width, int height)
+      {
+        Width    = width;
+        Height   = height;
+        RowWords = (width + 15) / 16;
+
+        Bits.assign(Height * RowWords, 0);
+      }
+
+      bool Pixel(int x, int y) const
+      {
+        return (Bits[y * RowWords + x / 16] >> (x % 16)) & 1;
+      }
+
+      //
+      // ORs glyph rows into the bitmap moved right and down by dx, dy.
+      //
+      void Stamp(const uint16_t* rows,
+                 int rowWords,
+                 int height,
+                 int dx, int dy)
+      {
+        for (int y = 0; y < height and y + dy < Height; y++)
+        {
+          StampRow(&rows[y * rowWords], rowWords, dx, y + dy);
+        }
+      }
+
+      //
+      // Shift goes through 32 bits so that carry lands in the next word.
+      //
+      void StampRow(const uint16_t* src, int srcWords, int dx, int y)
+      {
+        int wordShift = dx / 16;
+        int bitShift  = dx % 16;
+
+        uint16_t* dst = &Bits[y * RowWords];
+
+        for (int i = 0; i < srcWords; i++)
+        {
+          uint32_t word = (uint32_t)src[i] << bitShift;
+
+          int ind = i + wordShift;
+
+          if (ind < RowWords)
+          {
+            dst[ind] |= word & 0xFFFF;
+          }
+
+          if (ind + 1 < RowWords)
+          {
+            dst[ind + 1] |= word >> 16;
+          }
+        }
+      }
+
+      void Subtract(const Bitmap& other)
+      {
+        for (size_t i = 0; i < Bits.size(); i++)
+        {
+          Bits[i] &= ~other.Bits[i];
+        }
+      }
+    };
+
+    // -------------------------------------------------------------------------
+
+    struct MarkupState
+    {
+      uint32_t   Color;
+      TextEffect Effect;
+      TextStyle  Style;
+      size_t     Font;
+    };
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Part of visible markup text drawn with the same color and variant.
+    //
+    struct TextRun
+    {
+      size_t    Begin;
+      size_t    End;
+      SDL_Color Color;
+      size_t    Font;
+      size_t    Variant;
+    };
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Bump allocator for transient data of a batch, for trivial types
+    // only. When the current block runs out, a twice larger one is
+    // chained. Reset() merges the chain into a single block of their
+    // total size, so after the first busy frames a whole batch fits
+    // into one block and nothing is allocated.
+    //
+    struct FrameArena
+    {
+      template <typename T>
+      T* Allocate(size_t count)
+      {
+        size_t offset = (Used + alignof(T) - 1) & ~(alignof(T) - 1);
+        size_t size   = count * sizeof(T);
+
+        if (Blocks.empty() or offset + size > Blocks.back().size())
+        {
+          size_t next = Blocks.empty() ? kMinBlock : Blocks.back().size() * 2;
+
+          Blocks.emplace_back(std::max(next, size));
+          offset = 0;
+        }
+
+        Used = offset + size;
+
+        return (T*)(Blocks.back().data() + offset);
+      }
+
+      void Reset()
+      {
+        if (Blocks.size() > 1)
+        {
+          size_t total = 0;
+
+          for (const std::vector<uint8_t>& block : Blocks)
+          {
+            total += block.size();
+          }
+
+          Blocks.clear();
+          Blocks.emplace_back(total);
+        }
+
+        Used = 0;
+      }
+
+      static constexpr size_t kMinBlock = 4096;
+
+      std::vector<std::vector<uint8_t>> Blocks;
+
+      //
+      // Bytes taken from the last block.
+      //
+      size_t Used = 0;
+    };
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Marks code inside IF for the allocation check.
+    //
+    struct AllocScope
+    {
+      AllocScope()
+      {
+        Depth()++;
+      }
+
+      ~AllocScope()
+      {
+        Depth()--;
+      }
+
+      static int& Depth()
+      {
+        static thread_local int depth = 0;
+        return depth;
+      }
+    };
+
+    // -------------------------------------------------------------------------
+
+    static std::atomic<uint64_t>& AllocationCount()
+    {
+      static std::atomic<uint64_t> count { 0 };
+      return count;
+    }
+
+    // -------------------------------------------------------------------------
+
+    void CheckAllocations(const char* where)
+    {
+      uint64_t count = Allocations();
+
+      if (_expectNoAllocations and count != _allocationsChecked)
+      {
+        SDL_Log("%s: %llu allocations inside IF in steady state!",
+                where,
+                (unsigned long long)(count - _allocationsChecked));
+
+        SDL_assert_release(count == _allocationsChecked);
+      }
+
+      _allocationsChecked = count;
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Header of text record in PostBuffer, followed by the text
+    // and its terminating zero.
+    //
+    struct PostedText
+    {
+      double   Scale;
+      int32_t  X;
+      int32_t  Y;
+      uint32_t Color;
+      uint32_t Length;
+      uint8_t  Align;
+      uint8_t  Effect;
+      uint8_t  Style;
+      uint8_t  Markup;
+    };
+
+    //
+    // Length of record that tells to continue from the start of the buffer.
+    //
+    static constexpr uint32_t kPostWrap = UINT32_MAX;
+
+    //
+    // Single producer, single consumer ring of PostedText records.
+    // Head and Tail are byte counters that only grow: the posting thread
+    // advances Head after writing a record, render thread advances Tail
+    // after drawing it. Records never straddle the end of the buffer.
+    //
+    struct PostBuffer
+    {
+      SDL_threadID Thread = 0;
+      PostBuffer*  Next   = nullptr;
+
+      std::vector<uint8_t> Data;
+
+      std::atomic<size_t>   Head    { 0 };
+      std::atomic<size_t>   Tail    { 0 };
+      std::atomic<uint64_t> Dropped { 0 };
+
+      //
+      // Bytes taken by the last Reserve(), posting thread only.
+      //
+      size_t Reserved = 0;
+
+      static size_t RecordSize(size_t length)
+      {
+        return (sizeof(PostedText) + length + 1 + 7) & ~(size_t)7;
+      }
+
+      PostedText* Reserve(size_t length)
+      {
+        size_t capacity = Data.size();
+        size_t size     = RecordSize(length);
+
+        size_t head = Head.load(std::memory_order_relaxed);
+        size_t tail = Tail.load(std::memory_order_acquire);
+
+        size_t pos  = head % capacity;
+        size_t skip = (pos + size > capacity) ? capacity - pos : 0;
+
+        if (size + skip > capacity - (head - tail))
+        {
+          Dropped.fetch_add(1, std::memory_order_relaxed);
+          return nullptr;
+        }
+
+        if (skip >= sizeof(PostedText))
+        {
+          ((PostedText*)&Data[pos])->Length = kPostWrap;
+        }
+
+        Reserved = skip + size;
+
+        return (PostedText*)&Data[(pos + skip) % capacity];
+      }
+
+      void Commit()
+      {
+        size_t head = Head.load(std::memory_order_relaxed);
+        Head.store(head + Reserved, std::memory_order_release);
+      }
+    };
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Recorded frame. Stats collect submissions of it on the render thread.
+    //
+    struct FrameList
+    {
+      std::vector<SDL_Vertex> Vertices;
+      std::vector<int>        Indices;
+
+      size_t NumVertices = 0;
+
+      FrameStats Stats;
+    };
+
+    static constexpr size_t kNoList = (size_t)-1;
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Text or markup layout with quad positions relative to its x, y.
+    // Used is the time of the batch it was last printed in. Text and
+    // quads are kept in fixed slots of _cacheText and _cacheQuads.
+    //
+    struct CachedLayout
+    {
+      uint64_t Hash     = 0;
+      uint64_t LastUsed = 0;
+      uint64_t Used     = 0;
+      double   Scale    = 0.0;
+      size_t   Font     = 0;
+      uint32_t Color    = 0;
+      uint8_t  Align    = 0;
+      uint8_t  Effect   = 0;
+      uint8_t  Style    = 0;
+      bool     Markup   = false;
+      bool     Valid    = false;
+
+      uint32_t Length      = 0;
+      uint32_t NumVertices = 0;
+    };
+
+    static constexpr size_t kCacheWays = 4;
+
+    //
+    // Longest string the layout cache keeps, in bytes of text or markup.
+    //
+    static constexpr size_t kCacheMaxLength = 64;
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Common part of Print, PrintMarkup and Printf.
+    //
+    void PrintText(int x, int y,
+                   const char* text,
+                   size_t length,
+                   uint32_t color,
+                   TextAlignment align,
+                   double scaleFactor,
+                   TextEffect effect,
+                   TextStyle style,
+                   bool markup)
+    {
+      IF_ALLOC_SCOPE();
+
+      if (not _initialized)
+      {
+        SDL_Log("Font manager is not initialized!");
+        return;
+      }
+
+      IF_STATS(uint64_t layoutStart = SDL_GetPerformanceCounter());
+
+      LayoutCached(x, y,
+                   text, length,
+                   color, align, scaleFactor, effect, style,
+                   markup);
+
+      IF_STATS(_stats.LayoutTicks += SDL_GetPerformanceCounter() - layoutStart);
+
+      if (not _batching)
+      {
+        Flush();
+      }
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Appends quads of text or markup to the current batch, copied
+    // from the layout cache when the string was printed recently.
+    //
+    void LayoutCached(int x, int y,
+                      const char* text,
+                      size_t length,
+                      uint32_t color,
+                      TextAlignment align,
+                      double scaleFactor,
+                      TextEffect effect,
+                      TextStyle style,
+                      bool markup)
+    {
+      IF_TRACE_SCOPE("IF::Layout");
+
+      CachedLayout* cached = nullptr;
+
+      if (not _layoutCache.empty() and length <= kCacheMaxLength)
+      {
+        cached = FindLayout(text, length,
+                            color, align, scaleFactor, effect, style,
+                            markup);
+
+        if (cached != nullptr and cached->Valid)
+        {
+          ReplayLayout(*cached, x, y);
+          return;
+        }
+      }
+
+      size_t first = _numVertices;
+
+      if (markup)
+      {
+        LayoutMarkup(x, y,
+                     text, length,
+                     color, align, scaleFactor, effect, style);
+      }
+      else
+      {
+        LayoutText(x, y,
+                   text, length,
+                   color, align, scaleFactor, effect, style);
+      }
+
+      if (cached != nullptr)
+      {
+        StoreLayout(*cached, x, y, first);
+      }
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Appends quads of the text to the current batch.
+    //
+    void LayoutText(int x, int y,
+                    const char* text,
+                    size_t length,
+                    uint32_t color,
+                    TextAlignment align,
+                    double scaleFactor,
+                    TextEffect effect,
+                    TextStyle style)
+    {
+      _vertexColor = HTML2RGB(color);
+      _variant     = &_font->Variants[VariantIndex(style, effect)];
+
+      const uint8_t* chars = (const uint8_t*)text;
+
+      bool perGlyph = PerGlyph(*_font, chars, 0, length);
+
+      if (perGlyph)
+      {
+        _penX = _arena.Allocate<int>(length);
+      }
+
+      //
+      // For proportional fonts text width is in pixels and comes from
+      // prefix sum of advances, which is then reused for glyph positions.
+      //
+      int ln = perGlyph ? LayoutPen(chars, 0, length, 0) : length;
+
+      LayoutRun(x, y,
+                chars, 0, length,
+                AlignOffset(align, ln),
+                scaleFactor,
+                perGlyph);
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Appends quads of all markup runs to the current batch.
+    //
+    void LayoutMarkup(int x, int y,
+                      const char* text,
+                      size_t length,
+                      uint32_t color,
+                      TextAlignment align,
+                      double scaleFactor,
+                      TextEffect effect,
+                      TextStyle style)
+    {
+      ParseMarkup(text, length, color, effect, style);
+
+      const uint8_t* chars = (const uint8_t*)_markupText;
+
+      const TextRun* runsEnd = _runs + _numRuns;
+
+      const FontSlot* selected = _font;
+
+      //
+      // Runs in other fonts can't share the grid of the selected one.
+      //
+      bool perGlyph = false;
+
+      for (const TextRun* run = _runs; run != runsEnd; run++)
+      {
+        const FontSlot& font = _fonts[run->Font];
+
+        if (&font != selected
+         or PerGlyph(font, chars, run->Begin, run->End))
+        {
+          perGlyph = true;
+        }
+      }
+
+      int ln = _markupLength;
+
+      if (perGlyph)
+      {
+        _penX = _arena.Allocate<int>(_markupLength);
+
+        ln = 0;
+
+        for (const TextRun* run = _runs; run != runsEnd; run++)
+        {
+          _variant = &_fonts[run->Font].Variants[run->Variant];
+          ln = LayoutPen(chars, run->Begin, run->End, ln);
+        }
+      }
+
+      int xOffset = AlignOffset(align, ln);
+
+      for (const TextRun* run = _runs; run != runsEnd; run++)
+      {
+        _font        = &_fonts[run->Font];
+        _vertexColor = run->Color;
+        _variant     = &_font->Variants[run->Variant];
+
+        LayoutRun(x, y,
+                  chars, run->Begin, run->End,
+                  xOffset,
+                  scaleFactor,
+                  perGlyph);
+      }
+
+      _font = selected;
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Splits markup into visible text (_markupText) and runs
+    // of the same color and variant (_runs), both in the arena.
+    // Neither can be longer than the markup itself.
+    //
+    void ParseMarkup(const char* text,
+                     size_t length,
+                     uint32_t color,
+                     TextEffect effect,
+                     TextStyle style)
+    {
+      _markupText   = _arena.Allocate<char>(length);
+      _markupLength = 0;
+
+      _runs    = _arena.Allocate<TextRun>(length);
+      _numRuns = 0;
+
+      const MarkupState initial = { color, effect, style, SelectedFont() };
+
+      MarkupState state = initial;
+
+      size_t runStart = 0;
+
+      auto CloseRun = [this, &state, &runStart]()
+      {
+        if (_markupLength > runStart)
+        {
+          TextRun& run = _runs[_numRuns++];
+          run.Begin   = runStart;
+          run.End     = _markupLength;
+          run.Color   = HTML2RGB(state.Color);
+          run.Font    = state.Font;
+          run.Variant = VariantIndex(state.Style, state.Effect);
+
+          runStart = run.End;
+        }
+      };
+
+      size_t i = 0;
+
+      while (i < length)
+      {
+        if (text[i] == '{')
+        {
+          if (i + 1 < length and text[i + 1] == '{')
+          {
+            _markupText[_markupLength++] = '{';
+            i += 2;
+            continue;
+          }
+
+          const char* close =
+            (const char*)std::memchr(text + i, '}', length - i);
+
+          MarkupState next = state;
+
+          if (close != nullptr
+          and ParseTag(&text[i + 1], close - text - i - 1, initial, next))
+          {
+            if (next.Color  != state.Color
+             or next.Effect != state.Effect
+             or next.Style  != state.Style
+             or next.Font   != state.Font)
+            {
+              CloseRun();
+              state = next;
+            }
+
+            i = close - text + 1;
+            continue;
+          }
+        }
+
+        _markupText[_markupLength++] = text[i];
+        i++;
+      }
+
+      CloseRun();
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Applies tag (without braces) to the state.
+    // Returns false if it's not a tag.
+    //
+    bool ParseTag(const char* tag,
+                  size_t length,
+                  const MarkupState& initial,
+                  MarkupState& state) const
+    {
+      if ((length == 7 or length == 9) and tag[0] == '#')
+      {
+        uint32_t color = 0;
+
+        for (size_t i = 1; i < length; i++)
+        {
+          char c = tag[i];
+
+          if (not std::isxdigit((unsigned char)c))
+          {
+            return false;
+          }
+
+          int digit = (c <= '9') ? c - '0' : (std::tolower(c) - 'a' + 10);
+
+          color = (color << 4) | digit;
+        }
+
+        //
+        // Color without alpha keeps the current one,
+        // so that translucent line stays translucent.
+        //
+        if (length == 7)
+        {
+          color |= state.Color & 0xFF000000;
+        }
+
+        state.Color = color;
+
+        return true;
+      }
+
+      if (length == 2 and tag[0] == 'f' and std::isdigit((unsigned char)tag[1]))
+      {
+        size_t font = tag[1] - '0';
+
+        if (font >= _fonts.size())
+        {
+          return false;
+        }
+
+        state.Font = font;
+
+        return true;
+      }
+
+      if (length != 1)
+      {
+        return false;
+      }
+
+      //
+      // Style values have bold in bit 0 and italic in bit 1.
+      //
+      size_t style = (size_t)state.Style;
+
+      switch (tag[0])
+      {
+        // --------------------------
+        case 'b':
+          state.Style = (TextStyle)(style | 1);
+          break;
+        // --------------------------
+        case 'i':
+          state.Style = (TextStyle)(style | 2);
+          break;
+        // --------------------------
+        case 'r':
+          state.Style = TextStyle::REGULAR;
+          break;
+        // --------------------------
+        case 'o':
+          state.Effect = TextEffect::OUTLINE;
+          break;
+        // --------------------------
+        case 's':
+          state.Effect = TextEffect::SHADOW;
+          break;
+        // --------------------------
+        case 'n':
+          state.Effect = TextEffect::NONE;
+          break;
+        // --------------------------
+        case '/':
+          state = initial;
+          break;
+        // --------------------------
+        default:
+          return false;
+        // --------------------------
+      }
+
+      return true;
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Offset of the text start relative to x, in characters for monospace
+    // fonts and in pixels for proportional ones (same units as width).
+    //
+    static int AlignOffset(TextAlignment align, int width)
+    {
+      int xOffset = 0;
+
+      switch (align)
+      {
+        // --------------------------
+        case TextAlignment::LEFT:
+          xOffset = 0;
+          break;
+        // --------------------------
+        case TextAlignment::RIGHT:
+          xOffset = -width;
+          break;
+        // --------------------------
+        case TextAlignment::CENTER:
+          xOffset = -(width / 2);
+          break;
+        // --------------------------
+        default:
+          break;
+        // --------------------------
+      }
+
+      return xOffset;
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Proportional fonts and text with glyphs borrowed from other fonts
+    // can't use fixed grid.
+    //
+    static bool PerGlyph(const FontSlot& font,
+                         const uint8_t* chars,
+                         size_t begin, size_t end)
+    {
+      if (font.Proportional)
+      {
+        return true;
+      }
+
+      if (font.Mixed)
+      {
+        for (size_t i = begin; i < end; i++)
+        {
+          if (font.Foreign[chars[i]])
+          {
+            return true;
+          }
+        }
+      }
+
+      return false;
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Appends quads for characters [begin, end) of the text, which is
+    // positioned as a whole by xOffset. Uses current font, color
+    // and variant. Per glyph layout needs _penX filled by LayoutPen().
+    //
+    void LayoutRun(int x, int y,
+                   const uint8_t* chars,
+                   size_t begin, size_t end,
+                   int xOffset,
+                   double scaleFactor,
+                   bool perGlyph)
+    {
+      if (perGlyph)
+      {
+        int intScale = (int)scaleFactor;
+
+        if ((double)intScale == scaleFactor)
+        {
+          DrawGlyphsProportional(IntScale { intScale },
+                                 x, y,
+                                 chars, begin, end,
+                                 xOffset);
+        }
+        else
+        {
+          DrawGlyphsProportional(RealScale { scaleFactor },
+                                 x, y,
+                                 chars, begin, end,
+                                 xOffset);
+        }
+      }
+      else
+      {
+        PrintMonospace(x, y,
+                       chars + begin, end - begin,
+                       xOffset + (int)begin,
+                       scaleFactor);
+      }
+    }
+
+    // -------------------------------------------------------------------------
+
+    void PrintMonospace(int x, int y,
+                        const uint8_t* chars,
+                        size_t ln,
+                        int xOffset,
+                        double scaleFactor)
+    {
+      //
+      // Common cell sizes get their own instantiation: the pen moves
+      // in whole pixels, by a compile-time constant step at scale 1
+      // and by a constant multiple of the scale otherwise.
+      //
+      if (_font->GlyphWidth == 9 and _font->GlyphHeight == 9)
+      {
+        PrintScaled(FixedGeometry<9, 9>(),
+                    x, y, chars, ln, xOffset, scaleFactor);
+      }
+      else if (_font->GlyphWidth == 8 and _font->GlyphHeight == 8)
+      {
+        PrintScaled(FixedGeometry<8, 8>(),
+                    x, y, chars, ln, xOffset, scaleFactor);
+      }
+      else if (_font->GlyphWidth == 8 and _font->GlyphHeight == 16)
+      {
+        PrintScaled(FixedGeometry<8, 16>(),
+                    x, y, chars, ln, xOffset, scaleFactor);
+      }
+      else if (_font->GlyphWidth == 12 and _font->GlyphHeight == 24)
+      {
+        PrintScaled(FixedGeometry<12, 24>(),
+                    x, y, chars, ln, xOffset, scaleFactor);
+      }
+      else if (_font->GlyphWidth == 16 and _font->GlyphHeight == 32)
+      {
+        PrintScaled(FixedGeometry<16, 32>(),
+                    x, y, chars, ln, xOffset, scaleFactor);
+      }
+      else
+      {
+        RuntimeGeometry geometry = { _font->GlyphWidth, _font->GlyphHeight };
+        PrintScaled(geometry, x, y, chars, ln, xOffset, scaleFactor);
+      }
+    }
+
+    // -------------------------------------------------------------------------
+
+    template <uint16_t GlyphWidth, uint16_t GlyphHeight>
+    struct FixedGeometry
+    {
+      static constexpr int Width()  { return GlyphWidth;  }
+      static constexpr int Height() { return GlyphHeight; }
+    };
+
+    // -------------------------------------------------------------------------
+
+    struct RuntimeGeometry
+    {
+      int GlyphWidth;
+      int GlyphHeight;
+
+      int Width()  const { return GlyphWidth;  }
+      int Height() const { return GlyphHeight; }
+    };
+
+    // -------------------------------------------------------------------------
+
+    struct UnitScale
+    {
+      constexpr int operator()(int value) const { return value; }
+    };
+
+    // -------------------------------------------------------------------------
+
+    struct IntScale
+    {
+      int Factor;
+
+      int operator()(int value) const { return value * Factor; }
+    };
+
+    // -------------------------------------------------------------------------
+
+    struct RealScale
+    {
+      double Factor;
+
+      int operator()(int value) const
+      {
+        return (int)( (double)value * Factor );
+      }
+    };
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Whole scale factors give exactly the same result in integer math,
+    // so floating point is used only for fractional ones.
+    //
+    template <typename Geometry>
+    void PrintScaled(const Geometry& geometry,
+                     int x, int y,
+                     const uint8_t* chars,
+                     size_t ln,
+                     int xOffset,
+                     double scaleFactor)
+    {
+      int intScale = (int)scaleFactor;
+
+      if (intScale == 1 and scaleFactor == 1.0)
+      {
+        DrawGlyphs(geometry, UnitScale(),
+                   x, y, chars, ln, xOffset);
+      }
+      else if ((double)intScale == scaleFactor)
+      {
+        DrawGlyphs(geometry, IntScale { intScale },
+                   x, y, chars, ln, xOffset);
+      }
+      else
+      {
+        DrawGlyphs(geometry, RealScale { scaleFactor },
+                   x, y, chars, ln, xOffset);
+      }
+    }
+
+    // -------------------------------------------------------------------------
+
+    template <typename Geometry, typename Scale>
+    void DrawGlyphs(const Geometry& geometry,
+                    const Scale& scale,
+                    int x, int y,
+                    const uint8_t* chars,
+                    size_t ln,
+                    int xOffset)
+    {
+      //
+      // Effect variants have bigger cells than the glyph itself,
+      // pen still moves by glyph width.
+      //
+      const Variant& variant = *_variant;
+
+      //
+      // Scaled sizes are whole pixels, so the pen is an integer.
+      //
+      const int advance = scale(geometry.Width());
+
+      int   startX = x + scale(xOffset * geometry.Width() + variant.OffsetX);
+      float top    = y + scale(variant.OffsetY);
+      float w      = scale(variant.Width);
+      float h      = scale(variant.Height);
+
+      SDL_Vertex* out = ReserveQuads(ln);
+
+      IF_STATS(const SDL_Vertex* first = out);
+
+      size_t i = 0;
+
+      if (_vectorized and ln >= kVectorizeThreshold)
+      {
+        i = BuildQuadsVectorized(chars, ln, startX, top, advance, w, h, out);
+      }
+
+      int penX = startX + (int)i * advance;
+
+      for (; i < ln; i++, penX += advance)
+      {
+        const GlyphInfo& glyph = variant.Glyphs[chars[i]];
+
+        if (not glyph.Empty)
+        {
+          out = WriteQuad(out,
+                          (float)penX, top, w, h,
+                          glyph.U0, glyph.V0, glyph.U1, glyph.V1);
+        }
+      }
+
+      IF_STATS(_stats.GlyphsCulled += ln - (out - first) / 4);
+
+      CommitQuads(out);
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Builds quads for blocks of 8 characters with AVX2:
+    // glyph lookups are gathered and pen positions computed in vector
+    // registers, then only visible glyphs are written out.
+    // SSE4.1 has no gather, so such builds stay on the scalar loop.
+    // Returns number of characters processed, the tail is left to the caller.
+    //
+    size_t BuildQuadsVectorized(const uint8_t* chars,
+                                size_t ln,
+                                float x, float y,
+                                float advance,
+                                float w, float h,
+                                SDL_Vertex*& out)
+    {
+      size_t i = 0;
+
+#if defined(__AVX2__)
+      const Variant& variant = *_variant;
+
+      alignas(32) float px[8];
+      alignas(32) float u0[8];
+      alignas(32) float v0[8];
+      alignas(32) float u1[8];
+      alignas(32) float v1[8];
+
+      const __m256 lanes = _mm256_mul_ps(_mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7),
+                                         _mm256_set1_ps(advance));
+
+      for (; i + 8 <= ln; i += 8)
+      {
+        __m128i bytes = _mm_loadl_epi64((const __m128i*)(chars + i));
+        __m256i ind   = _mm256_cvtepu8_epi32(bytes);
+
+        __m256i visible = _mm256_i32gather_epi32(variant.Visible, ind, 4);
+
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(visible));
+        if (mask == 0)
+        {
+          continue;
+        }
+
+        __m256 base = _mm256_set1_ps(x + (float)i * advance);
+
+        _mm256_store_ps(px, _mm256_add_ps(base, lanes));
+        _mm256_store_ps(u0, _mm256_i32gather_ps(variant.U0, ind, 4));
+        _mm256_store_ps(v0, _mm256_i32gather_ps(variant.V0, ind, 4));
+        _mm256_store_ps(u1, _mm256_i32gather_ps(variant.U1, ind, 4));
+        _mm256_store_ps(v1, _mm256_i32gather_ps(variant.V1, ind, 4));
+
+        for (int k = 0; k < 8; k++)
+        {
+          if (mask & (1 << k))
+          {
+            out = WriteQuad(out, px[k], y, w, h, u0[k], v0[k], u1[k], v1[k]);
+          }
+        }
+      }
+#endif
+
+      return i;
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Makes sure vertex buffer has room for count more quads and returns
+    // pointer to where the next one should be written.
+    //
+    SDL_Vertex* ReserveQuads(size_t count)
+    {
+      size_t needed = _numVertices + count * 4;
+
+      if (_vertices.size() < needed)
+      {
+        _vertices.resize(needed);
+      }
+
+      return _vertices.data() + _numVertices;
+    }
+
+    // -------------------------------------------------------------------------
+
+    void CommitQuads(const SDL_Vertex* end)
+    {
+      _numVertices = end - _vertices.data();
+    }
+
+    // -------------------------------------------------------------------------
+
+    SDL_Vertex* WriteQuad(SDL_Vertex* v,
+                          float x, float y,
+                          float w, float h,
+                          float u0, float v0,
+                          float u1, float v1)
+    {
+      v[0].position  = { x, y };
+      v[0].color     = _vertexColor;
+      v[0].tex_coord = { u0, v0 };
+
+      v[1].position  = { x + w, y };
+      v[1].color     = _vertexColor;
+      v[1].tex_coord = { u1, v0 };
+
+      v[2].position  = { x, y + h };
+      v[2].color     = _vertexColor;
+      v[2].tex_coord = { u0, v1 };
+
+      v[3].position  = { x + w, y + h };
+      v[3].color     = _vertexColor;
+      v[3].tex_coord = { u1, v1 };
+
+      return v + 4;
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Index pattern is the same for every quad, so it's built once
+    // and only extended when batch grows beyond it.
+    //
+    static void BuildIndices(std::vector<int>& indices, size_t numQuads)
+    {
+      size_t from = indices.size() / 6;
+
+      indices.resize(numQuads * 6);
+
+      for (size_t i = from; i < numQuads; i++)
+      {
+        int v = i * 4;
+        int* ind = &indices[i * 6];
+
+        ind[0] = v;
+        ind[1] = v + 1;
+        ind[2] = v + 2;
+        ind[3] = v + 2;
+        ind[4] = v + 1;
+        ind[5] = v + 3;
+      }
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Draws quads with indices built for at least as many of them.
+    //
+    void Submit(const SDL_Vertex* vertices,
+                size_t numVertices,
+                const int* indices,
+                FrameStats& stats)
+    {
+      IF_STATS(uint64_t submitStart = SDL_GetPerformanceCounter());
+
+      size_t numQuads = numVertices / 4;
+
+      bool useGeometry = _useGeometry.load(std::memory_order_relaxed);
+
+      if (useGeometry)
+      {
+        int res = SDL_RenderGeometry(_rendererRef,
+                                     _fontAtlas,
+                                     vertices,
+                                     numVertices,
+                                     indices,
+                                     numQuads * 6);
+        if (res < 0)
+        {
+          SDL_Log("SDL_RenderGeometry failed (%s)"
+                  " - falling back to SDL_RenderCopy", SDL_GetError());
+          _useGeometry = false;
+          useGeometry  = false;
+        }
+        else
+        {
+          IF_STATS(stats.DrawCalls++);
+        }
+      }
+
+      if (not useGeometry)
+      {
+        FlushRenderCopy(vertices, numVertices, stats);
+      }
+
+      IF_STATS(stats.GlyphsSubmitted += numQuads);
+      IF_STATS(stats.SubmitTicks += SDL_GetPerformanceCounter() - submitStart);
+    }
+
+    // -------------------------------------------------------------------------
+
+    void AddSubmitStats(const FrameStats& stats)
+    {
+      IF_STATS(_stats.GlyphsSubmitted     += stats.GlyphsSubmitted);
+      IF_STATS(_stats.DrawCalls           += stats.DrawCalls);
+      IF_STATS(_stats.TextureStateChanges += stats.TextureStateChanges);
+      IF_STATS(_stats.SubmitTicks         += stats.SubmitTicks);
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // For renderers without geometry support: every quad is drawn
+    // with SDL_RenderCopyF and color goes through texture color
+    // and alpha mod, which are only changed when the color does.
+    //
+    void FlushRenderCopy(const SDL_Vertex* vertices,
+                         size_t numVertices,
+                         FrameStats& stats)
+    {
+      SaveColor();
+
+      SDL_Color current = _oldColor;
+
+      for (size_t i = 0; i < numVertices; i += 4)
+      {
+        const SDL_Vertex& tl = vertices[i];
+        const SDL_Vertex& br = vertices[i + 3];
+
+        if (tl.color.r != current.r
+         or tl.color.g != current.g
+         or tl.color.b != current.b)
+        {
+          current.r = tl.color.r;
+          current.g = tl.color.g;
+          current.b = tl.color.b;
+          SDL_SetTextureColorMod(_fontAtlas, current.r, current.g, current.b);
+
+          IF_STATS(stats.TextureStateChanges++);
+        }
+
+        if (tl.color.a != current.a)
+        {
+          current.a = tl.color.a;
+          SDL_SetTextureAlphaMod(_fontAtlas, current.a);
+
+          IF_STATS(stats.TextureStateChanges++);
+        }
+
+        SDL_Rect src;
+        src.x = (int)std::lround(tl.tex_coord.x * _atlasWidth);
+        src.y = (int)std::lround(tl.tex_coord.y * _atlasHeight);
+        src.w = (int)std::lround(br.tex_coord.x * _atlasWidth)  - src.x;
+        src.h = (int)std::lround(br.tex_coord.y * _atlasHeight) - src.y;
+
+        SDL_FRect dst;
+        dst.x = tl.position.x;
+        dst.y = tl.position.y;
+        dst.w = br.position.x - tl.position.x;
+        dst.h = br.position.y - tl.position.y;
+
+        SDL_RenderCopyF(_rendererRef, _fontAtlas, &src, &dst);
+
+        IF_STATS(stats.DrawCalls++);
+      }
+
+      RestoreColor();
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // First 32 bit format with alpha among those the renderer lists
+    // (its native one comes first), or RGBA32 for SDL to convert.
+    //
+    static uint32_t AtlasFormat(SDL_Renderer* renderer)
+    {
+      SDL_RendererInfo info;
+      if (SDL_GetRendererInfo(renderer, &info) < 0)
+      {
+        return SDL_PIXELFORMAT_RGBA32;
+      }
+
+      for (uint32_t i = 0; i < info.num_texture_formats; i++)
+      {
+        uint32_t format = info.texture_formats[i];
+
+        if (not SDL_ISPIXELFORMAT_FOURCC(format)
+        and SDL_ISPIXELFORMAT_PACKED(format)
+        and SDL_ISPIXELFORMAT_ALPHA(format)
+        and SDL_BITSPERPIXEL(format) == 32)
+        {
+          return format;
+        }
+      }
+
+      return SDL_PIXELFORMAT_RGBA32;
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Creates atlas texture from _atlasCoverage. Atlas doesn't change
+    // after that, so it's built in the format renderer prefers and
+    // uploaded once into a static texture: backends neither convert it
+    // nor keep a shadow copy.
+    //
+    bool UploadAtlas()
+    {
+      uint32_t format = AtlasFormat(_rendererRef);
+
+      SDL_PixelFormat* pixelFormat = SDL_AllocFormat(format);
+      if (pixelFormat == nullptr)
+      {
+        SDL_Log("%s", SDL_GetError());
+        return false;
+      }
+
+      uint32_t* palette = _atlasPalette;
+      palette[kCoverNone] = SDL_MapRGBA(pixelFormat,   0,   0,   0,   0);
+      palette[kCoverFill] = SDL_MapRGBA(pixelFormat, 255, 255, 255, 255);
+      palette[kCoverEdge] = SDL_MapRGBA(pixelFormat,   0,   0,   0, 255);
+
+      SDL_FreeFormat(pixelFormat);
+
+      _fontAtlas = SDL_CreateTexture(_rendererRef,
+                                     format,
+                                     SDL_TEXTUREACCESS_STATIC,
+                                     _atlasWidth, _atlasHeight);
+      if (_fontAtlas == nullptr)
+      {
+        SDL_Log("%s", SDL_GetError());
+        return false;
+      }
+
+      std::vector<uint32_t> pixels(_atlasCoverage.size());
+
+      for (size_t i = 0; i < pixels.size(); i++)
+      {
+        pixels[i] = palette[_atlasCoverage[i]];
+      }
+
+      int res = SDL_UpdateTexture(_fontAtlas,
+                                  nullptr,
+                                  pixels.data(),
+                                  _atlasWidth * sizeof(uint32_t));
+      if (res < 0)
+      {
+        SDL_Log("%s", SDL_GetError());
+        return false;
+      }
+
+      res = SDL_SetTextureBlendMode(_fontAtlas, SDL_BLENDMODE_BLEND);
+      if (res < 0)
+      {
+        SDL_Log("%s", SDL_GetError());
+        return false;
+      }
+
+      return true;
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Uploads part of _atlasCoverage into the same place of the texture.
+    //
+    bool UploadTile(const SDL_Rect& tile)
+    {
+      _tilePixels.resize((size_t)tile.w * tile.h);
+
+      for (int y = 0; y < tile.h; y++)
+      {
+        const uint8_t* in =
+          &_atlasCoverage[(tile.y + y) * _atlasWidth + tile.x];
+
+        for (int x = 0; x < tile.w; x++)
+        {
+          _tilePixels[y * tile.w + x] = _atlasPalette[in[x]];
+        }
+      }
+
+      int res = SDL_UpdateTexture(_fontAtlas,
+                                  &tile,
+                                  _tilePixels.data(),
+                                  tile.w * sizeof(uint32_t));
+      if (res < 0)
+      {
+        SDL_Log("%s", SDL_GetError());
+        return false;
+      }
+
+      return true;
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Checks that glyph data is consistent with font dimensions.
+    //
+    static bool ValidateFont(const Font& font)
+    {
+      if (font.Glyphs.empty()
+       or font.GlyphWidth == 0
+       or font.GlyphHeight == 0
+       or font.RowWords != (font.GlyphWidth + 15) / 16
+       or font.Fallback >= font.Glyphs.size()
+       or (not font.Advances.empty()
+           and font.Advances.size() != font.Glyphs.size()))
+      {
+        SDL_Log("Invalid font!");
+        return false;
+      }
+
+      for (const auto& glyph : font.Glyphs)
+      {
+        if (glyph.size() != (size_t)font.GlyphHeight * font.RowWords)
+        {
+          SDL_Log("Invalid glyph data!");
+          return false;
+        }
+      }
+
+      return true;
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Copies what's needed for layout out of the font: after Init
+    // glyph bitmaps live only in the atlas.
+    //
+    void SetupFont(FontSlot& slot, const Font& font)
+    {
+      slot.GlyphWidth   = font.GlyphWidth;
+      slot.GlyphHeight  = font.GlyphHeight;
+      slot.OriginX      = font.OriginX;
+      slot.Proportional = not font.Advances.empty();
+      slot.Fallback     = font.Fallback;
+      slot.NumGlyphs    = font.Glyphs.size();
+      slot.BlockBase    = font.Glyphs.size() - kBlockLevels;
+      slot.Advances     = font.Advances;
+
+      slot.Empty.resize(font.Glyphs.size());
+
+      for (size_t i = 0; i < font.Glyphs.size(); i++)
+      {
+        const auto& rows = font.Glyphs[i];
+
+        slot.Empty[i] = std::all_of(rows.begin(),
+                                    rows.end(),
+                                    [](uint16_t word) { return word == 0; });
+      }
+
+      for (uint32_t c = 0; c < 256; c++)
+      {
+        auto it = font.Codepoints.find(c);
+
+        bool found = (it != font.Codepoints.end()
+                  and it->second < font.Glyphs.size());
+
+        slot.Own[c] = found ? (int32_t)it->second : -1;
+      }
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Resolves every byte value to its glyph once, so that Print does
+    // only one table load per character. Glyph is taken from the font
+    // itself, then from fonts of its fallback chain, and if nobody
+    // has it, font's fallback glyph is used.
+    //
+    void BuildGlyphTable(size_t fontId)
+    {
+      FontSlot& slot = _fonts[fontId];
+
+      slot.Mixed = false;
+
+      for (uint32_t c = 0; c < 256; c++)
+      {
+        size_t  source  = fontId;
+        int32_t charInd = slot.Own[c];
+
+        for (size_t other : slot.Chain)
+        {
+          if (charInd >= 0)
+          {
+            break;
+          }
+
+          if (_fonts[other].Own[c] >= 0)
+          {
+            source  = other;
+            charInd = _fonts[other].Own[c];
+          }
+        }
+
+        if (charInd < 0)
+        {
+          charInd = slot.Fallback;
+        }
+
+        const FontSlot& from = _fonts[source];
+
+        slot.Foreign[c] = (source != fontId);
+
+        if (slot.Foreign[c])
+        {
+          slot.Mixed = true;
+        }
+
+        //
+        // Glyph of another font is centered vertically in the line.
+        //
+        int centerY = (slot.GlyphHeight - from.GlyphHeight) / 2;
+
+        for (size_t i = 0; i < kNumVariants; i++)
+        {
+          Variant& variant = slot.Variants[i];
+
+          GlyphInfo& glyph = variant.Glyphs[c];
+
+          glyph = MakeGlyph(from, i, charInd, centerY);
+
+          variant.U0[c] = glyph.U0;
+          variant.V0[c] = glyph.V0;
+          variant.U1[c] = glyph.U1;
+          variant.V1[c] = glyph.V1;
+
+          variant.Visible[c] = glyph.Empty ? 0 : -1;
+        }
+      }
+
+      size_t plain = VariantIndex(TextStyle::REGULAR, TextEffect::NONE);
+
+      for (int level = 0; level < kBlockLevels; level++)
+      {
+        slot.Blocks[level] = MakeGlyph(slot, plain, slot.BlockBase + level, 0);
+      }
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Glyph charInd of the font in its region of given variant,
+    // moved down by centerY.
+    //
+    GlyphInfo MakeGlyph(const FontSlot& from,
+                        size_t variantIndex,
+                        uint32_t charInd,
+                        int centerY) const
+    {
+      const Variant& region = from.Variants[variantIndex];
+
+      GlyphInfo glyph;
+
+      glyph.Index  = charInd;
+      glyph.Source = TileRect(region, charInd);
+
+      float w = _atlasWidth;
+      float h = _atlasHeight;
+
+      glyph.U0 = (float)glyph.Source.x / w;
+      glyph.V0 = (float)glyph.Source.y / h;
+      glyph.U1 = (float)(glyph.Source.x + glyph.Source.w) / w;
+      glyph.V1 = (float)(glyph.Source.y + glyph.Source.h) / h;
+
+      glyph.OffsetX = region.OffsetX + from.OriginX;
+      glyph.OffsetY = region.OffsetY + centerY;
+
+      glyph.Advance = from.Proportional ? from.Advances[charInd]
+                                        : from.GlyphWidth;
+
+      glyph.Empty = from.Empty[charInd];
+
+      return glyph;
+    }
+
+    // -------------------------------------------------------------------------
+
+    static SDL_Rect TileRect(const Variant& region, uint32_t charInd)
+    {
+      SDL_Rect tile;
+
+      tile.x = region.AtlasX + (charInd % _numTilesH) * region.Width;
+      tile.y = region.AtlasY + (charInd / _numTilesH) * region.Height;
+      tile.w = region.Width;
+      tile.h = region.Height;
+
+      return tile;
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Copy of the font with only glyphs mapped from codepoints below 256
+    // and the fallback one, in the same order.
+    //
+    static Font ReachableGlyphs(const Font& font)
+    {
+      const uint32_t kDropped = UINT32_MAX;
+
+      std::vector<uint32_t> remap(font.Glyphs.size(), kDropped);
+
+      remap[font.Fallback] = 0;
+
+      for (const auto& entry : font.Codepoints)
+      {
+        if (entry.first < 256 and entry.second < font.Glyphs.size())
+        {
+          remap[entry.second] = 0;
+        }
+      }
+
+      Font reachable;
+      reachable.Reset(font.GlyphWidth, font.GlyphHeight);
+      reachable.OriginX = font.OriginX;
+
+      for (uint32_t i = 0; i < font.Glyphs.size(); i++)
+      {
+        if (remap[i] == kDropped)
+        {
+          continue;
+        }
+
+        remap[i] = reachable.Glyphs.size();
+
+        reachable.Glyphs.push_back(font.Glyphs[i]);
+
+        if (not font.Advances.empty())
+        {
+          reachable.Advances.push_back(font.Advances[i]);
+        }
+      }
+
+      for (const auto& entry : font.Codepoints)
+      {
+        if (entry.first < 256 and entry.second < font.Glyphs.size())
+        {
+          reachable.Codepoints[entry.first] = remap[entry.second];
+        }
+      }
+
+      reachable.Fallback = remap[font.Fallback];
+
+      return reachable;
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Appends block glyphs from the lowest eighth of the cell
+    // up to the full cell.
+    //
+    static void AddBlockGlyphs(Font& font)
+    {
+      for (int level = 1; level <= kBlockLevels; level++)
+      {
+        uint32_t glyph = font.AddGlyph();
+
+        int height = std::max(1, (font.GlyphHeight * level + kBlockLevels / 2)
+                                 / kBlockLevels);
+
+        for (size_t y = font.GlyphHeight - height; y < font.GlyphHeight; y++)
+        {
+          for (size_t x = 0; x < font.GlyphWidth; x++)
+          {
+            font.SetPixel(glyph, x, y);
+          }
+        }
+
+        if (not font.Advances.empty())
+        {
+          font.Advances.push_back(font.GlyphWidth);
+        }
+      }
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Decides cell size of every variant of every font and packs their
+    // regions into the atlas: side by side while they fit into
+    // kMaxAtlasWidth, then on the next shelf. Fails if the atlas
+    // wouldn't fit into a texture of the renderer.
+    //
+    bool PackRegions(SDL_Renderer* renderer)
+    {
+      //
+      // Wide enough not to overflow before the size is checked.
+      //
+      int64_t shelfX      = 0;
+      int64_t shelfY      = 0;
+      int64_t shelfHeight = 0;
+
+      int64_t atlasWidth  = 0;
+      int64_t atlasHeight = 0;
+
+      for (FontSlot& slot : _fonts)
+      {
+        int64_t numTilesV = (slot.NumGlyphs + _spareGlyphs + _numTilesH - 1)
+                          / _numTilesH;
+
+        slot.NumTiles = numTilesV * _numTilesH;
+
+        for (size_t i = 0; i < kNumVariants; i++)
+        {
+          Variant& variant = slot.Variants[i];
+
+          variant.Style  = (TextStyle)(i / kNumEffects);
+          variant.Effect = (TextEffect)(i % kNumEffects);
+
+          int width  = StyleWidth(slot.GlyphWidth,
+                                  slot.GlyphHeight,
+                                  variant.Style);
+          int height = slot.GlyphHeight;
+
+          switch (variant.Effect)
+          {
+            // --------------------------
+            case TextEffect::OUTLINE:
+              variant.Width   = width  + 2;
+              variant.Height  = height + 2;
+              variant.OffsetX = -1;
+              variant.OffsetY = -1;
+              break;
+            // --------------------------
+            case TextEffect::SHADOW:
+              variant.Width   = width  + 1;
+              variant.Height  = height + 1;
+              variant.OffsetX = 0;
+              variant.OffsetY = 0;
+              break;
+            // --------------------------
+            default:
+              variant.Width   = width;
+              variant.Height  = height;
+              variant.OffsetX = 0;
+              variant.OffsetY = 0;
+              break;
+            // --------------------------
+          }
+
+          int64_t regionWidth  = _numTilesH * variant.Width;
+          int64_t regionHeight = numTilesV  * variant.Height;
+
+          if (shelfX > 0 and shelfX + regionWidth > kMaxAtlasWidth)
+          {
+            shelfX       = 0;
+            shelfY      += shelfHeight;
+            shelfHeight  = 0;
+          }
+
+          variant.AtlasX = shelfX;
+          variant.AtlasY = shelfY;
+
+          shelfX      += regionWidth;
+          shelfHeight  = std::max(shelfHeight, regionHeight);
+
+          atlasWidth  = std::max(atlasWidth, shelfX);
+          atlasHeight = std::max(atlasHeight, shelfY + shelfHeight);
+        }
+      }
+
+      if (not AtlasFits(renderer, atlasWidth, atlasHeight))
+      {
+        return false;
+      }
+
+      _atlasWidth  = atlasWidth;
+      _atlasHeight = atlasHeight;
+
+      return true;
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Checks atlas size against the largest texture the renderer
+    // can create and against UINT16_MAX the size is kept in.
+    //
+    bool AtlasFits(SDL_Renderer* renderer,
+                   int64_t atlasWidth,
+                   int64_t atlasHeight)
+    {
+      int64_t maxWidth  = UINT16_MAX;
+      int64_t maxHeight = UINT16_MAX;
+
+      //
+      // Renderers that don't know their limit report 0.
+      //
+      SDL_RendererInfo info;
+      if (SDL_GetRendererInfo(renderer, &info) == 0)
+      {
+        if (info.max_texture_width > 0)
+        {
+          maxWidth = std::min(maxWidth, (int64_t)info.max_texture_width);
+        }
+
+        if (info.max_texture_height > 0)
+        {
+          maxHeight = std::min(maxHeight, (int64_t)info.max_texture_height);
+        }
+      }
+
+      if (atlasWidth > maxWidth or atlasHeight > maxHeight)
+      {
+        SDL_Log("Atlas of %lldx%lld doesn't fit into %lldx%lld texture!",
+                (long long)atlasWidth, (long long)atlasHeight,
+                (long long)maxWidth, (long long)maxHeight);
+        return false;
+      }
+
+      return true;
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Produces atlas tile of a glyph for given variant: fill pixels
+    // are drawn white (tinted by text color), edge pixels opaque black.
+    // Style is applied first, then outline (styled glyph dilated by one
+    // pixel in every direction) or shadow (styled glyph moved one pixel
+    // right and down), both with the glyph itself cut out.
+    //
+    void RenderVariant(const FontSlot& font,
+                       const uint16_t* rows,
+                       const Variant& variant,
+                       Bitmap& base,
+                       Bitmap& fill,
+                       Bitmap& edge)
+    {
+      int rowWords = (font.GlyphWidth + 15) / 16;
+
+      bool bold   = (variant.Style == TextStyle::BOLD
+                  or variant.Style == TextStyle::BOLD_ITALIC);
+      bool italic = (variant.Style == TextStyle::ITALIC
+                  or variant.Style == TextStyle::BOLD_ITALIC);
+
+      base.Reset(StyleWidth(font.GlyphWidth, font.GlyphHeight, variant.Style),
+                 font.GlyphHeight);
+
+      for (int y = 0; y < font.GlyphHeight; y++)
+      {
+        const uint16_t* row = &rows[y * rowWords];
+
+        int dx = italic ? ItalicShift(font.GlyphHeight, y) : 0;
+
+        base.StampRow(row, rowWords, dx, y);
+
+        if (bold)
+        {
+          base.StampRow(row, rowWords, dx + 1, y);
+        }
+      }
+
+      const uint16_t* styled = base.Bits.data();
+
+      int styledWords = base.RowWords;
+      int height      = base.Height;
+
+      fill.Reset(variant.Width, variant.Height);
+      edge.Reset(variant.Width, variant.Height);
+
+      switch (variant.Effect)
+      {
+        // --------------------------
+        case TextEffect::OUTLINE:
+          fill.Stamp(styled, styledWords, height, 1, 1);
+
+          for (int dy = 0; dy <= 2; dy++)
+          {
+            for (int dx = 0; dx <= 2; dx++)
+            {
+              edge.Stamp(styled, styledWords, height, dx, dy);
+            }
+          }
+
+          edge.Subtract(fill);
+          break;
+        // --------------------------
+        case TextEffect::SHADOW:
+          fill.Stamp(styled, styledWords, height, 0, 0);
+          edge.Stamp(styled, styledWords, height, 1, 1);
+          edge.Subtract(fill);
+          break;
+        // --------------------------
+        default:
+          fill.Stamp(styled, styledWords, height, 0, 0);
+          break;
+        // --------------------------
+      }
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Renders glyph into its tile of every variant of the font
+    // in _atlasCoverage.
+    //
+    void DrawTiles(const FontSlot& font,
+                   uint32_t charInd,
+                   const uint16_t* rows,
+                   Bitmap& base,
+                   Bitmap& fill,
+                   Bitmap& edge)
+    {
+      for (const Variant& variant : font.Variants)
+      {
+        RenderVariant(font, rows, variant, base, fill, edge);
+
+        SDL_Rect tile = TileRect(variant, charInd);
+
+        for (int row = 0; row < tile.h; row++)
+        {
+          uint8_t* out = &_atlasCoverage[(tile.y + row) * _atlasWidth + tile.x];
+
+          for (int col = 0; col < tile.w; col++)
+          {
+            if (fill.Pixel(col, row))
+            {
+              out[col] = kCoverFill;
+            }
+            else if (edge.Pixel(col, row))
+            {
+              out[col] = kCoverEdge;
+            }
+            else
+            {
+              out[col] = kCoverNone;
+            }
+          }
+        }
+      }
+    }
+
+    // -------------------------------------------------------------------------
+
+    static size_t VariantIndex(TextStyle style, TextEffect effect)
+    {
+      return (size_t)style * kNumEffects + (size_t)effect;
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Italic slant is about 14 degrees: top row is moved right
+    // by a quarter of glyph height, bottom row stays in place.
+    //
+    static int ItalicShear(int glyphHeight)
+    {
+      return std::max(1, glyphHeight / 4);
+    }
+
+    // -------------------------------------------------------------------------
+
+    static int ItalicShift(int glyphHeight, int y)
+    {
+      int span  = std::max(1, glyphHeight - 1);
+      int shear = ItalicShear(glyphHeight);
+
+      return ((glyphHeight - 1 - y) * shear * 2 + span) / (span * 2);
+    }
+
+    // -------------------------------------------------------------------------
+
+    static int StyleWidth(int glyphWidth, int glyphHeight, TextStyle style)
+    {
+      int width = glyphWidth;
+
+      if (style == TextStyle::BOLD or style == TextStyle::BOLD_ITALIC)
+      {
+        width += 1;
+      }
+
+      if (style == TextStyle::ITALIC or style == TextStyle::BOLD_ITALIC)
+      {
+        width += ItalicShear(glyphHeight);
+      }
+
+      return width;
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Fills _penX with pen position of characters [begin, end)
+    // starting from given one and returns pen position after the last
+    // character, so for the whole text it's text width in pixels.
+    // _penX must have room for end positions.
+    //
+    int LayoutPen(const uint8_t* chars, size_t begin, size_t end, int pen)
+    {
+      for (size_t i = begin; i < end; i++)
+      {
+        _penX[i] = pen;
+        pen += _variant->Glyphs[chars[i]].Advance;
+      }
+
+      return pen;
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Every glyph has its own position and size here:
+    // glyphs of other fonts may have different cell.
+    //
+    template <typename Scale>
+    void DrawGlyphsProportional(const Scale& scale,
+                                int x, int y,
+                                const uint8_t* chars,
+                                size_t begin, size_t end,
+                                int xOffset)
+    {
+      const Variant& variant = *_variant;
+
+      SDL_Vertex* out = ReserveQuads(end - begin);
+
+      IF_STATS(const SDL_Vertex* first = out);
+
+      for (size_t i = begin; i < end; i++)
+      {
+        const GlyphInfo& glyph = variant.Glyphs[chars[i]];
+
+        if (glyph.Empty)
+        {
+          continue;
+        }
+
+        out = WriteQuad(out,
+                        x + scale(xOffset + _penX[i] + glyph.OffsetX),
+                        y + scale(glyph.OffsetY),
+                        scale(glyph.Source.w),
+                        scale(glyph.Source.h),
+                        glyph.U0, glyph.V0, glyph.U1, glyph.V1);
+      }
+
+      IF_STATS(_stats.GlyphsCulled += (end - begin) - (out - first) / 4);
+
+      CommitQuads(out);
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Colors are 0xAARRGGBB. Zero alpha means opaque, so that plain
+    // 0xRRGGBB values keep working (fully transparent text isn't worth
+    // drawing anyway).
+    //
+    const SDL_Color& HTML2RGB(const uint32_t& colorMask)
+    {
+      uint8_t alpha = (colorMask & _maskA) >> 24;
+
+      _drawColor.r = (colorMask & _maskR) >> 16;
+      _drawColor.g = (colorMask & _maskG) >> 8;
+      _drawColor.b = (colorMask & _maskB);
+      _drawColor.a = (alpha == 0) ? 0xFF : alpha;
+
+      return _drawColor;
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Multiplicative hash over 8 byte words.
+    //
+    static uint64_t HashText(const char* data, size_t length, uint64_t seed)
+    {
+      const uint64_t kMul = 0x9E3779B97F4A7C15ull;
+
+      uint64_t h = seed ^ (length * kMul);
+
+      size_t i = 0;
+
+      for (; i + 8 <= length; i += 8)
+      {
+        uint64_t word;
+        std::memcpy(&word, data + i, 8);
+
+        h = (h ^ word) * kMul;
+        h ^= h >> 29;
+      }
+
+      uint64_t tail = 0;
+      std::memcpy(&tail, data + i, length - i);
+
+      h = (h ^ tail) * kMul;
+      h ^= h >> 32;
+
+      return h;
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Returns either the valid entry for the string or the one
+    // to be filled by StoreLayout(), with the key already set.
+    //
+    // Strings are stored only when missed a second time, so text that
+    // changes every frame doesn't push out the strings that repeat:
+    // first miss just leaves the hash in the seen marks of the set,
+    // which are kept apart from the entries, and returns nullptr.
+    //
+    CachedLayout* FindLayout(const char* text,
+                             size_t length,
+                             uint32_t color,
+                             TextAlignment align,
+                             double scaleFactor,
+                             TextEffect effect,
+                             TextStyle style,
+                             bool markup)
+    {
+      size_t font = SelectedFont();
+
+      uint64_t seed = (uint64_t)font
+                    | ((uint64_t)align  << 8)
+                    | ((uint64_t)effect << 16)
+                    | ((uint64_t)style  << 24)
+                    | ((uint64_t)markup << 28);
+
+      uint64_t hash = HashText(text, length, seed ^ ((uint64_t)color << 32));
+
+      size_t first = (hash & _cacheSetMask) * kCacheWays;
+
+      CachedLayout* set    = &_layoutCache[first];
+      CachedLayout* victim = set;
+
+      _cacheStamp++;
+
+      for (size_t way = 0; way < kCacheWays; way++)
+      {
+        CachedLayout& entry = set[way];
+
+        if (entry.Valid
+        and entry.Hash   == hash
+        and entry.Scale  == scaleFactor
+        and entry.Font   == font
+        and entry.Color  == color
+        and entry.Align  == (uint8_t)align
+        and entry.Effect == (uint8_t)effect
+        and entry.Style  == (uint8_t)style
+        and entry.Markup == markup
+        and entry.Length == length
+        and std::memcmp(CachedText(entry), text, length) == 0)
+        {
+          entry.LastUsed = _cacheStamp;
+          entry.Used     = _cacheNow;
+
+          IF_STATS(_stats.LayoutCacheHits++);
+
+          return &entry;
+        }
+
+        //
+        // Invalid entries are replaced first, then least recently used.
+        //
+        if (entry.Valid == victim->Valid)
+        {
+          if (entry.LastUsed < victim->LastUsed)
+          {
+            victim = &entry;
+          }
+        }
+        else if (victim->Valid)
+        {
+          victim = &entry;
+        }
+      }
+
+      IF_STATS(_stats.LayoutCacheMisses++);
+
+      uint64_t& seen = _cacheSeen[first + ((hash >> 32) & (kCacheWays - 1))];
+
+      if (seen != hash)
+      {
+        seen = hash;
+        return nullptr;
+      }
+
+      victim->Valid    = false;
+      victim->Hash     = hash;
+      victim->LastUsed = _cacheStamp;
+      victim->Used     = _cacheNow;
+      victim->Scale    = scaleFactor;
+      victim->Font     = font;
+      victim->Color    = color;
+      victim->Align    = (uint8_t)align;
+      victim->Effect   = (uint8_t)effect;
+      victim->Style    = (uint8_t)style;
+      victim->Markup   = markup;
+      victim->Length   = length;
+
+      std::memcpy(CachedText(*victim), text, length);
+
+      return victim;
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Saves quads appended since first, relative to x, y. Slot holds
+    // one quad per byte of the string, layout that took more isn't kept.
+    //
+    void StoreLayout(CachedLayout& entry, int x, int y, size_t first)
+    {
+      size_t count = _numVertices - first;
+
+      if (count > kCacheMaxLength * 4)
+      {
+        return;
+      }
+
+      SDL_Vertex* quads = CachedQuads(entry);
+
+      float fx = x;
+      float fy = y;
+
+      for (size_t i = 0; i < count; i++)
+      {
+        quads[i] = _vertices[first + i];
+
+        quads[i].position.x -= fx;
+        quads[i].position.y -= fy;
+      }
+
+      entry.NumVertices = count;
+      entry.Valid       = true;
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Appends cached quads moved to x, y.
+    //
+    void ReplayLayout(const CachedLayout& entry, int x, int y)
+    {
+      size_t count = entry.NumVertices;
+
+      SDL_Vertex* out = ReserveQuads(count / 4);
+
+      std::memcpy(out, CachedQuads(entry), count * sizeof(SDL_Vertex));
+
+      float fx = x;
+      float fy = y;
+
+      for (size_t i = 0; i < count; i++)
+      {
+        out[i].position.x += fx;
+        out[i].position.y += fy;
+      }
+
+      CommitQuads(out + count);
+    }
+
+    // -------------------------------------------------------------------------
+
+    void ClearLayoutCache()
+    {
+      for (CachedLayout& entry : _layoutCache)
+      {
+        entry.Valid = false;
+      }
+    }
+
+    // -------------------------------------------------------------------------
+
+    char* CachedText(const CachedLayout& entry)
+    {
+      return &_cacheText[(&entry - _layoutCache.data()) * kCacheMaxLength];
+    }
+
+    // -------------------------------------------------------------------------
+
+    SDL_Vertex* CachedQuads(const CachedLayout& entry)
+    {
+      size_t slot = &entry - _layoutCache.data();
+
+      return &_cacheQuads[slot * kCacheMaxLength * 4];
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Drops entries of one set that weren't used for maxAge before
+    // the batch that just ended, so the sweep is spread over batches.
+    // Their slots stay allocated for the next strings.
+    //
+    void AgeLayoutCache()
+    {
+      if (_layoutCache.empty())
+      {
+        return;
+      }
+
+      size_t set = _cacheSweep++ & _cacheSetMask;
+
+      for (size_t way = 0; way < kCacheWays; way++)
+      {
+        CachedLayout& entry = _layoutCache[set * kCacheWays + way];
+
+        if (_cacheNow - entry.Used > _cacheMaxAge)
+        {
+          entry.Valid = false;
+        }
+      }
+
+      _cacheNow = SDL_GetTicks64();
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Buffers are found by thread id, so a thread that reuses id
+    // of a finished one picks up its buffer.
+    //
+    PostBuffer* ThreadPostBuffer()
+    {
+      SDL_threadID thread = SDL_ThreadID();
+
+      PostBuffer* head = _postBuffers.load(std::memory_order_acquire);
+
+      for (PostBuffer* buffer = head; buffer; buffer = buffer->Next)
+      {
+        if (buffer->Thread == thread)
+        {
+          return buffer;
+        }
+      }
+
+      size_t capacity = std::max(_postBufferSize.load(), (size_t)256);
+
+      PostBuffer* buffer = new PostBuffer();
+      buffer->Thread = thread;
+      buffer->Data.resize((capacity + 7) & ~(size_t)7);
+      buffer->Next = head;
+
+      while (not _postBuffers.compare_exchange_weak(buffer->Next,
+                                                     buffer,
+                                                     std::memory_order_release,
+                                                     std::memory_order_acquire))
+      {
+      }
+
+      return buffer;
+    }
+
+    // -------------------------------------------------------------------------
+
+    static void FillPosted(PostedText& posted,
+                           int x, int y,
+                           size_t length,
+                           uint32_t color,
+                           TextAlignment align,
+                           double scaleFactor,
+                           TextEffect effect,
+                           TextStyle style,
+                           bool markup)
+    {
+      posted.Scale  = scaleFactor;
+      posted.X      = x;
+      posted.Y      = y;
+      posted.Color  = color;
+      posted.Length = length;
+      posted.Align  = (uint8_t)align;
+      posted.Effect = (uint8_t)effect;
+      posted.Style  = (uint8_t)style;
+      posted.Markup = markup;
+    }
+
+    // -------------------------------------------------------------------------
+
+    void PostText(int x, int y,
+                  const char* text,
+                  size_t length,
+                  uint32_t color,
+                  TextAlignment align,
+                  double scaleFactor,
+                  TextEffect effect,
+                  TextStyle style,
+                  bool markup)
+    {
+      IF_ALLOC_SCOPE();
+
+      if (length == 0)
+      {
+        return;
+      }
+
+      PostBuffer* buffer = ThreadPostBuffer();
+
+      PostedText* posted = buffer->Reserve(length);
+      if (posted == nullptr)
+      {
+        return;
+      }
+
+      FillPosted(*posted,
+                 x, y, length,
+                 color, align, scaleFactor,
+                 effect, style, markup);
+
+      char* out = (char*)(posted + 1);
+      std::memcpy(out, text, length);
+      out[length] = 0;
+
+      buffer->Commit();
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Appends everything posted so far to the current batch.
+    // Render thread only.
+    //
+    void LayoutPosted()
+    {
+      if (not _initialized)
+      {
+        return;
+      }
+
+      IF_STATS(uint64_t layoutStart = SDL_GetPerformanceCounter());
+
+      PostBuffer* head = _postBuffers.load(std::memory_order_acquire);
+
+      for (PostBuffer* buffer = head; buffer; buffer = buffer->Next)
+      {
+        IF_STATS(_stats.PostsDropped +=
+                 buffer->Dropped.exchange(0, std::memory_order_relaxed));
+
+        size_t capacity = buffer->Data.size();
+
+        size_t tail = buffer->Tail.load(std::memory_order_relaxed);
+        size_t end  = buffer->Head.load(std::memory_order_acquire);
+
+        while (tail != end)
+        {
+          size_t pos = tail % capacity;
+
+          const PostedText* posted = (const PostedText*)&buffer->Data[pos];
+
+          if (capacity - pos < sizeof(PostedText)
+           or posted->Length == kPostWrap)
+          {
+            tail += capacity - pos;
+            continue;
+          }
+
+          //
+          // Laid out in place, the record is only released below.
+          //
+          const char* text = (const char*)(posted + 1);
+
+          LayoutCached(posted->X, posted->Y,
+                       text, posted->Length,
+                       posted->Color,
+                       (TextAlignment)posted->Align,
+                       posted->Scale,
+                       (TextEffect)posted->Effect,
+                       (TextStyle)posted->Style,
+                       posted->Markup);
+
+          IF_STATS(_stats.TextPosted++);
+
+          tail += PostBuffer::RecordSize(posted->Length);
+        }
+
+        buffer->Tail.store(tail, std::memory_order_release);
+      }
+
+      IF_STATS(_stats.LayoutTicks += SDL_GetPerformanceCounter() - layoutStart);
+    }
+
+    // -------------------------------------------------------------------------
+
+    void SaveColor()
+    {
+      SDL_GetTextureColorMod(_fontAtlas,
+                             &_oldColor.r,
+                             &_oldColor.g,
+                             &_oldColor.b);
+      SDL_GetTextureAlphaMod(_fontAtlas, &_oldColor.a);
+    }
+
+    // -------------------------------------------------------------------------
+
+    void RestoreColor()
+    {
+      SDL_SetTextureColorMod(_fontAtlas,
+                             _oldColor.r,
+                             _oldColor.g,
+                             _oldColor.b);
+      SDL_SetTextureAlphaMod(_fontAtlas, _oldColor.a);
+    }
+
+    // -------------------------------------------------------------------------
+
+    static uint32_t ReadLE32(const uint8_t* p)
+    {
+      uint32_t value = 0;
+      std::memcpy(&value, p, sizeof(value));
+      return SDL_SwapLE32(value);
+    }
+
+    // -------------------------------------------------------------------------
+
+    //
+    // Decodes one UTF-8 sequence and advances p past it (at least one byte).
+    // Malformed sequences yield 0xFFFD.
+    //
+    static uint32_t DecodeUTF8(const uint8_t*& p, const uint8_t* end)
+    {
+      uint8_t lead = *p++;
+
+      size_t   tail = 0;
+      uint32_t cp   = 0;
+
+      if (lead < 0x80)
+      {
+        return lead;
+      }
+      else if ((lead & 0xE0) == 0xC0)
+      {
+        tail = 1;
+        cp   = lead & 0x1F;
+      }
+      else if ((lead & 0xF0) == 0xE0)
+      {
+        tail = 2;
+        cp   = lead & 0x0F;
+      }
+      else if ((lead & 0xF8) == 0xF0)
+      {
+        tail = 3;
+        cp   = lead & 0x07;
+      }
+      else
+      {
+        return 0xFFFD;
+      }
+
+      for (size_t i = 0; i < tail; i++)
+      {
+        if (p == end or (*p & 0xC0) != 0x80)
+        {
+          return 0xFFFD;
+        }
+
+        cp = (cp << 6) | (*p++ & 0x3F);
+      }
+
+      return cp;
+    }
+
+    // -------------------------------------------------------------------------
+
+    static bool ParsePSF2(const uint8_t* data, size_t size, Font& font)
+    {
+      const uint8_t kMagic[4] = { 0x72, 0xB5, 0x4A, 0x86 };
+      const uint32_t kHasUnicodeTable = 0x01;
+
+      if (size < 32 or std::memcmp(data, kMagic, sizeof(kMagic)) != 0)
+      {
+        SDL_Log("Not a PSF2 font!");
+        return false;
+      }
+
+      uint32_t headerSize = ReadLE32(data + 8);
+      uint32_t flags      = ReadLE32(data + 12);
+      uint32_t numGlyphs  = ReadLE32(data + 16);
+      uint32_t glyphBytes = ReadLE32(data + 20);
+      uint32_t height     = ReadLE32(data + 24);
+      uint32_t width      = ReadLE32(data + 28);
+
+      size_t stride = (width + 7) / 8;
+
+      uint64_t glyphsEnd = (uint64_t)headerSize
+                         + (uint64_t)numGlyphs * glyphBytes;
+
+      if (width == 0 or width > 0xFFFF
+       or height == 0 or height > 0xFFFF
+       or numGlyphs == 0
+       or glyphBytes < stride * height
+       or glyphsEnd > size)
+      {
+        SDL_Log("Corrupted PSF2 font!");
+        return false;
+      }
+
+      font.Reset(width, height);
+
+      for (uint32_t i = 0; i < numGlyphs; i++)
+      {
+        uint32_t glyph = font.AddGlyph();
+
+        const uint8_t* bitmap = data + headerSize + i * glyphBytes;
+
+        //
+        // PSF rows are stored most significant bit first.
+        //
+        for (size_t y = 0; y < height; y++)
+        {
+          for (size_t x = 0; x < width; x++)
+          {
+            if (bitmap[y * stride + (x / 8)] & (0x80 >> (x % 8)))
+            {
+              font.SetPixel(glyph, x, y);
+            }
+          }
+        }
+      }
+
+      if (flags & kHasUnicodeTable)
+      {
+        const uint8_t* p   = data + glyphsEnd;
+        const uint8_t* end = data + size;
+
+        for (uint32_t glyph = 0; glyph < numGlyphs and p < end; glyph++)
+        {
+          //
+          // Entry is a list of codepoints followed by optional 0xFE-prefixed
+          // combining sequences, terminated by 0xFF.
+          // Sequences can't be mapped to a single glyph, so skip them.
+          //
+          bool sequence = false;
+
+          while (p < end and *p != 0xFF)
+          {
+            if (*p == 0xFE)
+            {
+              sequence = true;
+              p++;
+              continue;
+            }
+
+            uint32_t cp = DecodeUTF8(p, end);
+            if (not sequence)
+            {
+              font.Codepoints.emplace(cp, glyph);
+            }
+          }
+
+          p++;
+        }
+      }
+      else
+      {
+        for (uint32_t glyph = 0; glyph < numGlyphs; glyph++)
+        {
+          font.Codepoints[glyph] = glyph;
+        }
+      }
+
+      font.AddFallbackGlyph();
+
+      return true;
+    }
+
+    // -------------------------------------------------------------------------
+
+    static bool ParseBDF(const std::string& text, Font& font)
+    {
+      int fbbW = 0, fbbH = 0, fbbX = 0, fbbY = 0;
+      int bbW  = 0, bbH  = 0, bbX  = 0, bbY  = 0;
+
+      int encoding = -1;
+      int dwidth   = 0;
+
+      std::vector<uint16_t> advances;
+
+      //
+      // Current bitmap row or -1 if not inside BITMAP ... ENDCHAR.
+      //
+      int row = -1;
+
+      uint32_t glyph = 0;
+
+      bool hasBox = false;
+
+      size_t pos = 0;
+      while (pos < text.length())
+      {
+        size_t eol = text.find('\n', pos);
+        if (eol == std::string::npos)
+        {
+          eol = text.length();
+        }
+
+        std::string line = text.substr(pos, eol - pos);
+
+        pos = eol + 1;
+
+        if (row >= 0)
+        {
+          if (line.compare(0, 7, "ENDCHAR") == 0)
+          {
+            row = -1;
+            continue;
+          }
+
+          for (int col = 0; encoding >= 0 and col < bbW; col++)
+          {
+            size_t digit = col / 4;
+            if (digit >= line.length())
+            {
+              break;
+            }
+
+            uint8_t c = line[digit];
+            if (not std::isxdigit(c))
+            {
+              break;
+            }
+
+            int nibble = std::isdigit(c) ? c - '0' : std::toupper(c) - 'A' + 10;
+
+            if (nibble & (0x08 >> (col % 4)))
+            {
+              int x = bbX - fbbX + col;
+              int y = (fbbH + fbbY) - (bbY + bbH) + row;
+
+              if (x >= 0 and x < fbbW and y >= 0 and y < fbbH)
+              {
+                font.SetPixel(glyph, x, y);
+              }
+            }
+          }
+
+          row++;
+          continue;
+        }
+
+        const char* str = line.data();
+
+        if (std::sscanf(str, "FONTBOUNDINGBOX %d %d %d %d",
+                        &fbbW, &fbbH, &fbbX, &fbbY) == 4)
+        {
+          if (fbbW <= 0 or fbbW > 0xFFFF or fbbH <= 0 or fbbH > 0xFFFF)
+          {
+            SDL_Log("Invalid font bounding box!");
+            return false;
+          }
+
+          font.Reset(fbbW, fbbH);
+          hasBox = true;
+        }
+        else if (line.compare(0, 9, "STARTCHAR") == 0)
+        {
+          encoding = -1;
+          dwidth   = fbbW;
+
+          bbW = fbbW;
+          bbH = fbbH;
+          bbX = fbbX;
+          bbY = fbbY;
+        }
+        else if (std::sscanf(str, "ENCODING %d", &encoding) == 1)
+        {
+        }
+        else if (std::sscanf(str, "DWIDTH %d", &dwidth) == 1)
+        {
+        }
+        else if (std::sscanf(str, "BBX %d %d %d %d",
+                             &bbW, &bbH, &bbX, &bbY) == 4)
+        {
+        }
+        else if (line.compare(0, 6, "BITMAP") == 0)
+        {
+          if (not hasBox)
+          {
+            SDL_Log("FONTBOUNDINGBOX is missing!");
+            return false;
+          }
+
+          //
+          // Unencoded glyphs (ENCODING -1) are skipped.
+          //
+          if (encoding >= 0)
+          {
+            glyph = font.AddGlyph();
+            font.Codepoints.emplace(encoding, glyph);
+
+            advances.push_back(std::max(dwidth, 0));
+          }
+
+          row = 0;
+        }
+      }
+
+      if (font.Glyphs.empty())
+      {
+        SDL_Log("No glyphs found!");
+        return false;
+      }
+
+      font.AddFallbackGlyph();
+
+      //
+      // Font is treated as proportional only if glyphs actually
+      // have different advances.
+      //
+      advances.push_back(fbbW);
+
+      for (uint16_t advance : advances)
+      {
+        if (advance != fbbW)
+        {
+          font.Advances = advances;
+          font.OriginX  = fbbX;
+          break;
+        }
+      }
+
+      return true;
+    }
+
+    const uint32_t _maskR = 0x00FF0000;
+    const uint32_t _maskG = 0x0000FF00;
+    const uint32_t _maskB = 0x000000FF;
+    const uint32_t _maskA = 0xFF000000;
+
+    SDL_Color _drawColor;
+    SDL_Color _oldColor;
+
+    bool _initialized = false;
+
+    static constexpr uint16_t _numTilesH = 16;
+
+    //
+    // What a pixel of the atlas is, it only has three colors.
+    //
+    static constexpr uint8_t kCoverNone   = 0;
+    static constexpr uint8_t kCoverFill   = 1;
+    static constexpr uint8_t kCoverEdge   = 2;
+    static constexpr uint8_t kCoverLevels = 3;
+
+    //
+    // One byte per atlas pixel, kept to recreate the texture
+    // and to update single glyphs.
+    //
+    std::vector<uint8_t> _atlasCoverage;
+
+    //
+    // Coverage values in pixel format of the texture.
+    //
+    uint32_t _atlasPalette[kCoverLevels] = { 0 };
+
+    std::vector<uint32_t> _tilePixels;
+
+    size_t _spareGlyphs = 0;
+
+    static constexpr int kMaxAtlasWidth = 1024;
+
+    uint16_t _atlasWidth  = 0;
+    uint16_t _atlasHeight = 0;
+
+    std::vector<FontSlot> _fonts;
+
+    const FontSlot* _font    = nullptr;
+    const Variant*  _variant = nullptr;
+
+    static constexpr size_t kVectorizeThreshold = 16;
+
+    bool _vectorized  = true;
+    bool _batching    = false;
+
+    //
+    // Read by whichever thread submits (render thread for pipelined
+    // frames), written there on fallback and by Init() / RestoreAtlas().
+    //
+    std::atomic<bool> _useGeometry { true };
+
+    SDL_Color _vertexColor = { 255, 255, 255, 255 };
+
+    //
+    // Vertex storage only grows, _numVertices is the actual batch size.
+    //
+    std::vector<SDL_Vertex> _vertices;
+    std::vector<int>        _indices;
+
+    size_t _numVertices = 0;
+
+    FrameStats _stats;
+
+    struct TraceEvent
+    {
+      const char*  Name     = nullptr;
+      uint64_t     Start    = 0;
+      uint64_t     Duration = 0;
+      SDL_threadID Thread   = 0;
+    };
+
+    std::vector<TraceEvent> _traceEvents;
+
+    std::atomic<size_t> _traceCount   { 0 };
+    std::atomic<size_t> _traceWriters { 0 };
+    std::atomic<bool>   _tracing      { false };
+
+    uint64_t _traceOrigin = 0;
+    uint64_t _batchStart  = 0;
+
+    //
+    // Transient data of the current batch: Printf output, markup
+    // buffers and pen positions. Reset by Flush() and EndFrame().
+    //
+    FrameArena _arena;
+
+    int* _penX = nullptr;
+
+    char*    _markupText   = nullptr;
+    size_t   _markupLength = 0;
+    TextRun* _runs         = nullptr;
+    size_t   _numRuns      = 0;
+
+    bool     _expectNoAllocations = false;
+    uint64_t _allocationsChecked  = 0;
+
+    //
+    // Buffers of threads that used Post*, newest first. Only grows.
+    //
+    std::atomic<PostBuffer*> _postBuffers    { nullptr };
+    std::atomic<size_t>      _postBufferSize { 64 * 1024 };
+
+    //
+    // Command lists of pipelined frames. Lists are free, recorded,
+    // ready (recorded, queued for drawing) or shown (drawn last).
+    //
+    std::vector<FrameList> _frameLists;
+    std::vector<size_t>    _freeLists;
+    std::deque<size_t>     _readyLists;
+
+    size_t _recordList = kNoList;
+    size_t _shownList  = kNoList;
+
+    std::mutex              _frameMutex;
+    std::condition_variable _frameFree;
+
+    //
+    // Sets of kCacheWays entries, see SetLayoutCache(). Every set also
+    // has kCacheWays seen marks, every entry fixed text and quad slots.
+    //
+    static constexpr size_t kDefaultCacheSets = 64;
+    static constexpr size_t kDefaultCacheSlots = kDefaultCacheSets
+                                               * kCacheWays;
+
+    std::vector<CachedLayout> _layoutCache =
+      std::vector<CachedLayout>(kDefaultCacheSlots);
+
+    std::vector<uint64_t> _cacheSeen =
+      std::vector<uint64_t>(kDefaultCacheSlots);
+
+    std::vector<char> _cacheText =
+      std::vector<char>(kDefaultCacheSlots * kCacheMaxLength);
+
+    std::vector<SDL_Vertex> _cacheQuads =
+      std::vector<SDL_Vertex>(kDefaultCacheSlots * kCacheMaxLength * 4);
+
+    size_t   _cacheSetMask = kDefaultCacheSets - 1;
+    uint32_t _cacheMaxAge  = 2000;
+    uint64_t _cacheNow     = 0;
+    uint64_t _cacheSweep   = 0;
+    uint64_t _cacheStamp   = 0;
 
     SDL_Texture*  _fontAtlas   = nullptr;
     SDL_Renderer* _rendererRef = nullptr;
 
-    using GlyphData = std::vector<std::vector<uint16_t>>;
     const GlyphData _charMap =
     {
       { 0, 0, 0, 0, 0, 0, 0, 0, 0 },